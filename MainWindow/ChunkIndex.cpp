@@ -0,0 +1,225 @@
+#include "ChunkIndex.h"
+#include "HashPipeline.h"
+
+#include <QDir>
+#include <QMutexLocker>
+#include <QObject>
+#include <QTemporaryFile>
+#include <algorithm>
+#include <cstring>
+#include <queue>
+
+constexpr size_t sRunRecords = 2 * 1024 * 1024;   // 32MB sorted in memory before going to disk
+constexpr size_t sReadRecords = 64 * 1024;   // per run while merging
+constexpr size_t sMaxChunkFiles = 32;   // a chunk in more files than this is filler (zeros, headers) and says nothing about similarity
+
+CChunkIndex::CChunkIndex( qint64 treeChunkSize ) :
+    fTreeChunkSize( treeChunkSize )
+{
+}
+
+CChunkIndex::~CChunkIndex()
+{
+}
+
+int CChunkIndex::numFiles() const
+{
+    QMutexLocker locker( &fMutex );
+    return static_cast< int >( fFiles.size() );
+}
+
+void CChunkIndex::addFile( const QString &fileName, qint64 size, const SDigest &digest, EHashMode mode, const QByteArray &chunks )
+{
+    auto isTree = ( mode == EHashMode::eTree );
+    if ( !isTree && ( mode != EHashMode::eContentDefined ) )
+        return;
+    auto numChunks = chunks.size() / ( isTree ? SDigest::sSize : CHashPipeline::sChunkRecordSize );
+    if ( numChunks == 0 )
+        return;
+
+    // a full run is swapped out and written once the lock is released, the other hashers keep adding to a new one
+    std::vector< std::vector< SRecord > > fullRuns;
+    QMutexLocker locker( &fMutex );
+    auto file = static_cast< quint32 >( fFiles.size() );
+    fFiles.push_back( { fileName, size, digest } );
+    for ( int ii = 0; ii < numChunks; ++ii )
+    {
+        if ( isTree )
+        {
+            // the chunk digests are in file order, every chunk but the last is a full buffer
+            quint64 hash;
+            std::memcpy( &hash, chunks.constData() + ii * SDigest::sSize, sizeof( hash ) );
+            auto length = std::min( fTreeChunkSize, size - ii * fTreeChunkSize );
+            if ( length <= 0 )
+                break;
+            fRun.push_back( { hash, file, static_cast< quint32 >( length ) } );
+        }
+        else
+            fRun.push_back( { CHashPipeline::chunkHash( chunks, ii ), file, CHashPipeline::chunkLength( chunks, ii ) } );
+        if ( fRun.size() >= sRunRecords )
+        {
+            fullRuns.emplace_back();
+            std::swap( fullRuns.back(), fRun );
+        }
+    }
+    locker.unlock();
+
+    for ( auto &&ii : fullRuns )
+        writeRun( ii );
+}
+
+bool CChunkIndex::writeRun( std::vector< SRecord > &run )
+{
+    std::sort( run.begin(), run.end(), []( const SRecord &lhs, const SRecord &rhs ) { return ( lhs.fHash != rhs.fHash ) ? ( lhs.fHash < rhs.fHash ) : ( lhs.fFile < rhs.fFile ); } );
+
+    QMutexLocker locker( &fFileMutex );
+    if ( !fErrorMsg.isEmpty() )
+    {
+        run.clear();
+        return false;
+    }
+
+    if ( !fFile )
+    {
+        fFile = std::make_unique< QTemporaryFile >( QDir::temp().absoluteFilePath( "chunks-XXXXXX.idx" ) );
+        if ( !fFile->open() )
+        {
+            fErrorMsg = QObject::tr( "Could not create the chunk index: %1" ).arg( fFile->errorString() );
+            run.clear();
+            return false;
+        }
+    }
+
+    auto size = static_cast< qint64 >( run.size() * sizeof( SRecord ) );
+    fFile->seek( fFile->size() );
+    SRun written{ fFile->pos(), static_cast< qint64 >( run.size() ) };
+    if ( fFile->write( reinterpret_cast< const char * >( run.data() ), size ) != size )
+    {
+        fErrorMsg = QObject::tr( "Could not write the chunk index: %1" ).arg( fFile->errorString() );
+        run.clear();
+        return false;
+    }
+    fRuns.push_back( written );
+    run.clear();
+    return true;
+}
+
+void CChunkIndex::addShared( const std::vector< SRecord > &records, std::vector< quint32 > &files, std::unordered_map< quint64, qint64 > &sharedBytes ) const
+{
+    // a chunk repeated inside one file is counted once
+    files.clear();
+    for ( auto &&ii : records )
+        files.push_back( ii.fFile );
+    std::sort( files.begin(), files.end() );
+    files.erase( std::unique( files.begin(), files.end() ), files.end() );
+    if ( ( files.size() < 2 ) || ( files.size() > sMaxChunkFiles ) )
+        return;
+
+    auto length = records.front().fLength;
+    for ( size_t ii = 0; ii < files.size(); ++ii )
+    {
+        for ( size_t jj = ii + 1; jj < files.size(); ++jj )
+            sharedBytes[ ( static_cast< quint64 >( files[ ii ] ) << 32 ) | files[ jj ] ] += length;
+    }
+}
+
+std::vector< CChunkIndex::SSimilarFiles > CChunkIndex::similarFiles( double minRatio, QString *errorMsg )
+{
+    QMutexLocker locker( &fMutex );
+    if ( !fRun.empty() )
+    {
+        std::vector< SRecord > run;
+        std::swap( run, fRun );
+        writeRun( run );
+    }
+    QMutexLocker fileLocker( &fFileMutex );
+    if ( !fErrorMsg.isEmpty() || !fFile )
+    {
+        if ( errorMsg )
+            *errorMsg = fErrorMsg;
+        return {};
+    }
+
+    // k way merge of the sorted runs, every run is read through a small buffer
+    struct SReader
+    {
+        qint64 fOffset{ 0 };
+        qint64 fRemaining{ 0 };
+        std::vector< SRecord > fBuffer;
+        size_t fPos{ 0 };
+    };
+    std::vector< SReader > readers( fRuns.size() );
+    auto fill = [ this ]( SReader &reader )
+    {
+        auto num = static_cast< size_t >( std::min< qint64 >( reader.fRemaining, sReadRecords ) );
+        reader.fBuffer.resize( num );
+        reader.fPos = 0;
+        if ( num == 0 )
+            return false;
+        auto size = static_cast< qint64 >( num * sizeof( SRecord ) );
+        if ( !fFile->seek( reader.fOffset ) || ( fFile->read( reinterpret_cast< char * >( reader.fBuffer.data() ), size ) != size ) )
+        {
+            fErrorMsg = QObject::tr( "Could not read the chunk index: %1" ).arg( fFile->errorString() );
+            reader.fBuffer.clear();
+            reader.fRemaining = 0;
+            return false;
+        }
+        reader.fOffset += size;
+        reader.fRemaining -= num;
+        return true;
+    };
+
+    using THead = std::pair< quint64, size_t >;   // hash and reader
+    std::priority_queue< THead, std::vector< THead >, std::greater< THead > > heads;
+    for ( size_t ii = 0; ii < fRuns.size(); ++ii )
+    {
+        readers[ ii ].fOffset = fRuns[ ii ].fOffset;
+        readers[ ii ].fRemaining = fRuns[ ii ].fNumRecords;
+        if ( fill( readers[ ii ] ) )
+            heads.emplace( readers[ ii ].fBuffer.front().fHash, ii );
+    }
+
+    std::unordered_map< quint64, qint64 > sharedBytes;   // by pair of files
+    std::vector< SRecord > sameChunk;
+    std::vector< quint32 > files;
+    while ( !heads.empty() )
+    {
+        auto head = heads.top();
+        heads.pop();
+        if ( !sameChunk.empty() && ( sameChunk.front().fHash != head.first ) )
+        {
+            addShared( sameChunk, files, sharedBytes );
+            sameChunk.clear();
+        }
+
+        auto &&reader = readers[ head.second ];
+        sameChunk.push_back( reader.fBuffer[ reader.fPos++ ] );
+        if ( ( reader.fPos < reader.fBuffer.size() ) || fill( reader ) )
+            heads.emplace( reader.fBuffer[ reader.fPos ].fHash, head.second );
+    }
+    if ( !sameChunk.empty() )
+        addShared( sameChunk, files, sharedBytes );
+
+    if ( !fErrorMsg.isEmpty() )
+    {
+        if ( errorMsg )
+            *errorMsg = fErrorMsg;
+        return {};
+    }
+
+    std::vector< SSimilarFiles > retVal;
+    for ( auto &&ii : sharedBytes )
+    {
+        auto &&file1 = fFiles[ ii.first >> 32 ];
+        auto &&file2 = fFiles[ ii.first & 0xFFFFFFFF ];
+        if ( file1.fDigest == file2.fDigest )
+            continue;
+
+        auto ratio = static_cast< double >( ii.second ) / std::max( file1.fSize, file2.fSize );
+        if ( ratio < minRatio )
+            continue;
+        retVal.push_back( { file1.fName, file2.fName, ii.second, std::min( ratio, 1.0 ) } );
+    }
+    std::sort( retVal.begin(), retVal.end(), []( const SSimilarFiles &lhs, const SSimilarFiles &rhs ) { return ( lhs.fRatio != rhs.fRatio ) ? ( lhs.fRatio > rhs.fRatio ) : ( lhs.fSharedBytes > rhs.fSharedBytes ); } );
+    return retVal;
+}
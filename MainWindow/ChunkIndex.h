@@ -0,0 +1,75 @@
+#ifndef CHUNKINDEX_H
+#define CHUNKINDEX_H
+
+#include "Digest.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class QTemporaryFile;
+
+// The chunks of the tree and content defined hashes, for finding files that share most of their data
+// Tree chunks only match at the same offset (files changed in place), content defined chunks match anywhere
+// The (chunk, file, length) records go to a temporary file as sorted runs that are merged when the similar files are asked for,
+// so the memory used is one run however many terabytes were scanned
+// addFile is called from the hashers, similarFiles once the scan is finished
+class CChunkIndex
+{
+public:
+    struct SSimilarFiles
+    {
+        QString fFile1;
+        QString fFile2;
+        qint64 fSharedBytes{ 0 };
+        double fRatio{ 0.0 };   // of the larger file
+    };
+
+    CChunkIndex( qint64 treeChunkSize );
+    ~CChunkIndex();
+
+    void addFile( const QString &fileName, qint64 size, const SDigest &digest, EHashMode mode, const QByteArray &chunks );
+    int numFiles() const;
+
+    // sorted by ratio, files with the same digest are exact duplicates and are not reported
+    std::vector< SSimilarFiles > similarFiles( double minRatio, QString *errorMsg = nullptr );
+
+private:
+#pragma pack( push, 1 )
+    struct SRecord
+    {
+        quint64 fHash;
+        quint32 fFile;
+        quint32 fLength;
+    };
+#pragma pack( pop )
+    struct SFile
+    {
+        QString fName;
+        qint64 fSize{ 0 };
+        SDigest fDigest;
+    };
+    struct SRun
+    {
+        qint64 fOffset{ 0 };   // in fFile
+        qint64 fNumRecords{ 0 };
+    };
+
+    bool writeRun( std::vector< SRecord > &run );   // sorts the run and appends it to fFile, called without fMutex
+    void addShared( const std::vector< SRecord > &records, std::vector< quint32 > &files, std::unordered_map< quint64, qint64 > &sharedBytes ) const;
+
+    qint64 fTreeChunkSize{ 0 };
+    mutable QMutex fMutex;   // the files and the run being filled
+    std::vector< SFile > fFiles;
+    std::vector< SRecord > fRun;
+
+    QMutex fFileMutex;   // the temporary file and its runs, a full run is sorted and written under this one only
+    std::unique_ptr< QTemporaryFile > fFile;
+    std::vector< SRun > fRuns;
+    QString fErrorMsg;
+};
+
+#endif
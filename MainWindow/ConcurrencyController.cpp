@@ -0,0 +1,127 @@
+#include "ConcurrencyController.h"
+#include "ScanProgress.h"
+
+#include <QDateTime>
+#include <QSettings>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <algorithm>
+
+constexpr int sSampleInterval = 2000;   // msecs
+constexpr int sReservedThreads = 1;   // the finder walking the tree runs on the same pool
+constexpr int sMaxPerCore = 8;   // network storage keeps improving well past the core count
+constexpr qint64 sPerFileCost = 64 * 1024;   // opening and closing a file costs about as much as reading this many bytes
+constexpr double sTolerance = 0.05;   // changes smaller than this are measurement noise
+constexpr double sLatencyBackoff = 1.5;
+constexpr int sPlateauProbe = 5;   // samples to hold on a plateau before probing again
+
+CConcurrencyController::CConcurrencyController( QThreadPool *pool, int maxConcurrency, QObject *parent ) :
+    QObject( parent ),
+    fPool( pool )
+{
+    auto ideal = std::max( 1, QThread::idealThreadCount() );
+    fMin = 1;
+    fMax = std::max( fMin, std::min( std::max( 4, ideal * sMaxPerCore ), maxConcurrency ) );
+
+    QSettings settings;
+    fConcurrency = std::clamp( settings.value( "ScanConcurrency", ideal ).toInt(), fMin, fMax );
+    fPool->setMaxThreadCount( fConcurrency + sReservedThreads );
+
+    fTimer = new QTimer( this );
+    fTimer->setInterval( sSampleInterval );
+    connect( fTimer, &QTimer::timeout, this, &CConcurrencyController::slotSample );
+}
+
+void CConcurrencyController::start( std::shared_ptr< CScanProgress > progress )
+{
+    fProgress = progress;
+    fDirection = 1;
+    fPlateauSamples = 0;
+    fSettling = true;
+    fLastRate = -1.0;
+    fLastLatency = -1.0;
+    fLastSample = sample();
+    fTimer->start();
+}
+
+void CConcurrencyController::stop()
+{
+    fTimer->stop();
+    fProgress.reset();
+
+    QSettings settings;
+    settings.setValue( "ScanConcurrency", fConcurrency );
+}
+
+CConcurrencyController::SSample CConcurrencyController::sample() const
+{
+    SSample retVal;
+    retVal.fTime = QDateTime::currentMSecsSinceEpoch();
+    if ( fProgress )
+    {
+        retVal.fBytes = fProgress->bytesHashed();
+        retVal.fJobs = fProgress->numJobsFinished();
+        retVal.fJobsRuntime = fProgress->jobsRuntime();
+    }
+    return retVal;
+}
+
+bool CConcurrencyController::setConcurrency( int concurrency )
+{
+    concurrency = std::clamp( concurrency, fMin, fMax );
+    if ( concurrency == fConcurrency )
+        return false;
+
+    fConcurrency = concurrency;
+    fPool->setMaxThreadCount( fConcurrency + sReservedThreads );
+    return true;
+}
+
+void CConcurrencyController::slotSample()
+{
+    auto curr = sample();
+    auto prev = fLastSample;
+    fLastSample = curr;
+    if ( fSettling )
+    {
+        fSettling = false;
+        return;
+    }
+
+    auto elapsed = curr.fTime - prev.fTime;
+    if ( elapsed <= 0 )
+        return;
+
+    auto jobs = curr.fJobs - prev.fJobs;
+    auto rate = ( ( curr.fBytes - prev.fBytes ) + sPerFileCost * jobs ) * 1000.0 / elapsed;
+    if ( rate <= 0.0 )
+        return;   // nothing hashed, still counting or walking
+
+    auto latency = ( jobs > 0 ) ? static_cast< double >( curr.fJobsRuntime - prev.fJobsRuntime ) / jobs : -1.0;
+
+    if ( fLastRate > 0.0 )
+    {
+        if ( rate < fLastRate * ( 1.0 - sTolerance ) )
+            fDirection = -fDirection;   // the last step hurt, go back and explore the other side
+        else if ( rate < fLastRate * ( 1.0 + sTolerance ) )
+        {
+            // on a plateau more jobs only add seeks and memory, so prefer fewer when they wait longer
+            if ( ( latency > 0.0 ) && ( fLastLatency > 0.0 ) && ( latency > fLastLatency * sLatencyBackoff ) )
+                fDirection = -1;
+            else if ( ++fPlateauSamples < sPlateauProbe )
+                return;
+        }
+    }
+    fPlateauSamples = 0;
+    fLastRate = rate;
+    fLastLatency = latency;
+
+    auto step = std::max( 1, fConcurrency / 8 );
+    if ( !setConcurrency( fConcurrency + fDirection * step ) )
+    {
+        fDirection = -fDirection;   // at a bound
+        setConcurrency( fConcurrency + fDirection * step );
+    }
+    fSettling = true;
+}
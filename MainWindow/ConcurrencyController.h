@@ -0,0 +1,60 @@
+#ifndef CONCURRENCYCONTROLLER_H
+#define CONCURRENCYCONTROLLER_H
+
+#include <QObject>
+#include <memory>
+
+class CScanProgress;
+class QThreadPool;
+class QTimer;
+
+// Sizes the hashing pool while a scan runs
+// The throughput of the hash jobs (bytes/sec, with a per file allowance so small file workloads count) is sampled
+// every few seconds, and the number of concurrent jobs is hill climbed toward the level where it stops improving,
+// stepping back down when the per job latency rises without a throughput gain
+// The level found is remembered, so the next scan on the same machine starts close to its optimum
+// Only the readers are sized, the hashers are CPU bound and stay at one per core
+class CConcurrencyController : public QObject
+{
+    Q_OBJECT
+public:
+    CConcurrencyController( QThreadPool *pool, int maxConcurrency, QObject *parent );   // maxConcurrency is the most jobs that can make progress at once
+
+    void start( std::shared_ptr< CScanProgress > progress );
+    void stop();
+
+    int concurrency() const { return fConcurrency; }
+    int minConcurrency() const { return fMin; }
+    int maxConcurrency() const { return fMax; }
+
+private Q_SLOTS:
+    void slotSample();
+
+private:
+    struct SSample
+    {
+        qint64 fTime{ 0 };
+        qint64 fBytes{ 0 };
+        int fJobs{ 0 };
+        qint64 fJobsRuntime{ 0 };
+    };
+
+    SSample sample() const;
+    bool setConcurrency( int concurrency );
+
+    QThreadPool *fPool{ nullptr };
+    QTimer *fTimer{ nullptr };
+    std::shared_ptr< CScanProgress > fProgress;
+
+    int fMin{ 1 };
+    int fMax{ 1 };
+    int fConcurrency{ 1 };
+    int fDirection{ 1 };
+    int fPlateauSamples{ 0 };
+    bool fSettling{ true };   // the first sample after a change still reflects the old level
+    SSample fLastSample;
+    double fLastRate{ -1.0 };
+    double fLastLatency{ -1.0 };
+};
+
+#endif
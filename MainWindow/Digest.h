@@ -0,0 +1,58 @@
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QString>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <optional>
+
+// How the digest of a file was computed, digests computed differently never match
+enum class EHashMode
+{
+    eWholeFile,   // MD5 of the contents
+    eTree,   // MD5 of the digests of fixed size chunks
+    eContentDefined   // MD5 of the digests of content defined chunks
+};
+
+// An MD5 digest, carried as its 16 bytes and only formatted as hex for display
+struct SDigest
+{
+    static constexpr int sSize = 16;
+
+    static SDigest fromBytes( const QByteArray &bytes )
+    {
+        SDigest retVal;
+        std::memcpy( retVal.fBytes.data(), bytes.constData(), std::min< size_t >( bytes.size(), sSize ) );
+        return retVal;
+    }
+
+    static std::optional< SDigest > fromHex( const QString &hex )
+    {
+        if ( hex.length() != 2 * sSize )
+            return {};
+        return fromBytes( QByteArray::fromHex( hex.toLatin1() ) );
+    }
+
+    QByteArray toBytes() const { return QByteArray( reinterpret_cast< const char * >( fBytes.data() ), sSize ); }
+    QString toHex() const { return QString::fromLatin1( toBytes().toHex() ); }
+
+    // the digest is uniformly distributed already, its first bytes are a good hash
+    quint64 hash() const
+    {
+        quint64 retVal;
+        std::memcpy( &retVal, fBytes.data(), sizeof( retVal ) );
+        return retVal;
+    }
+
+    bool operator==( const SDigest &rhs ) const { return fBytes == rhs.fBytes; }
+    bool operator!=( const SDigest &rhs ) const { return fBytes != rhs.fBytes; }
+    bool operator<( const SDigest &rhs ) const { return fBytes < rhs.fBytes; }
+
+    std::array< quint8, sSize > fBytes{};
+};
+Q_DECLARE_METATYPE( SDigest )
+
+#endif
@@ -0,0 +1,63 @@
+#include "DigestIndex.h"
+
+#include <algorithm>
+
+constexpr size_t sMinSlots = 1024;   // a power of two
+
+void CDigestIndex::clear()
+{
+    fSlots = {};
+    fUsed = 0;
+}
+
+void CDigestIndex::reserve( size_t count )
+{
+    auto size = sMinSlots;
+    while ( size * 3 < count * 4 )
+        size *= 2;
+    if ( size > fSlots.size() )
+        rehash( size );
+}
+
+size_t CDigestIndex::slotFor( const SDigest &digest ) const
+{
+    auto mask = fSlots.size() - 1;
+    auto slot = static_cast< size_t >( digest.hash() ) & mask;
+    while ( ( fSlots[ slot ].fValue != sEmpty ) && ( fSlots[ slot ].fDigest != digest ) )
+        slot = ( slot + 1 ) & mask;
+    return slot;
+}
+
+std::optional< quint32 > CDigestIndex::find( const SDigest &digest ) const
+{
+    if ( fSlots.empty() )
+        return {};
+    auto &&slot = fSlots[ slotFor( digest ) ];
+    if ( slot.fValue == sEmpty )
+        return {};
+    return slot.fValue;
+}
+
+void CDigestIndex::insert( const SDigest &digest, quint32 value )
+{
+    // kept at most 3/4 full so probe runs stay short
+    if ( ( fUsed + 1 ) * 4 > fSlots.size() * 3 )
+        rehash( std::max( sMinSlots, fSlots.size() * 2 ) );
+
+    auto &&slot = fSlots[ slotFor( digest ) ];
+    if ( slot.fValue == sEmpty )
+        fUsed++;
+    slot.fDigest = digest;
+    slot.fValue = value;
+}
+
+void CDigestIndex::rehash( size_t size )
+{
+    std::vector< SSlot > slots( size );
+    std::swap( slots, fSlots );
+    for ( auto &&ii : slots )
+    {
+        if ( ii.fValue != sEmpty )
+            fSlots[ slotFor( ii.fDigest ) ] = ii;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef DIGESTINDEX_H
+#define DIGESTINDEX_H
+
+#include "Digest.h"
+
+#include <optional>
+#include <vector>
+
+// Maps digests to small integers in one flat, open addressed array of (digest, value) slots
+// A lookup normally reads one or two 20 byte slots, which touch one or two cache lines
+// The array is a power of two kept at most 3/4 full, so 2M digests take 4M slots (80MB),
+// and the rehash that grows it holds the old array as well (120MB)
+// Entries are never removed
+class CDigestIndex
+{
+public:
+    CDigestIndex() = default;
+
+    void clear();
+    void reserve( size_t count );
+    size_t size() const { return fUsed; }
+
+    std::optional< quint32 > find( const SDigest &digest ) const;
+    void insert( const SDigest &digest, quint32 value );   // replaces the value of a known digest
+
+private:
+    static constexpr quint32 sEmpty = ~quint32( 0 );
+    struct SSlot
+    {
+        SDigest fDigest;
+        quint32 fValue{ sEmpty };
+    };
+
+    size_t slotFor( const SDigest &digest ) const;   // where the digest is, or the empty slot it goes in
+    void rehash( size_t size );
+
+    std::vector< SSlot > fSlots;
+    size_t fUsed{ 0 };
+};
+
+#endif
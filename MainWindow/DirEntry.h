@@ -0,0 +1,36 @@
+#ifndef DIRENTRY_H
+#define DIRENTRY_H
+
+#include <QFileInfo>
+#include <QDateTime>
+#include <QString>
+
+// one record from a directory enumeration, everything the walk needs without going back to the filesystem
+struct SDirEntry
+{
+    SDirEntry() = default;
+    SDirEntry( const QFileInfo &fi ) :
+        fName( fi.fileName() ),
+        fIsDir( fi.isDir() ),
+        fIsHidden( fi.isHidden() ),
+        fSize( fi.isDir() ? 0 : fi.size() ),
+        fMTime( fi.lastModified().toMSecsSinceEpoch() ),
+        fCTime( fi.metadataChangeTime().toMSecsSinceEpoch() )
+    {
+    }
+
+    QString suffix() const
+    {
+        auto pos = fName.lastIndexOf( '.' );
+        return ( pos < 0 ) ? QString() : fName.mid( pos + 1 );
+    }
+
+    QString fName;
+    bool fIsDir{ false };
+    bool fIsHidden{ false };
+    qint64 fSize{ 0 };
+    qint64 fMTime{ 0 };   // msecs since epoch
+    qint64 fCTime{ 0 };   // msecs since epoch
+};
+
+#endif
@@ -0,0 +1,261 @@
+#include "DirWatcher.h"
+#include "FileFinder.h"
+#include "MainWindow.h"
+
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QThreadPool>
+#include <QTimer>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <climits>
+#include <unistd.h>
+
+// directory changes and the end of every write to a file in the directory
+constexpr uint32_t sWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+
+constexpr int sCoalesceDelay = 2000;   // msecs, gives writers a chance to finish before the files are hashed
+
+CDirWatcher::CDirWatcher( CFileFinder *finder, QObject *parent ) :
+    QObject( parent ),
+    fFinder( finder ),
+    fWatcher( new QFileSystemWatcher( this ) ),
+    fTimer( new QTimer( this ) )
+{
+    fTimer->setSingleShot( true );
+    fTimer->setInterval( sCoalesceDelay );
+
+#ifdef Q_OS_LINUX
+    fInotifyFD = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if ( fInotifyFD >= 0 )
+    {
+        fInotifyNotifier = new QSocketNotifier( fInotifyFD, QSocketNotifier::Read, this );
+        connect( fInotifyNotifier, &QSocketNotifier::activated, this, &CDirWatcher::slotReadInotify );
+    }
+    else
+        qWarning() << "Could not initialize inotify, files rewritten in place will not be detected";
+#endif
+
+    connect( fWatcher, &QFileSystemWatcher::directoryChanged, this, &CDirWatcher::slotDirectoryChanged );
+    connect( fTimer, &QTimer::timeout, this, &CDirWatcher::slotRescan );
+    connect( fFinder, &CFileFinder::sigFinished, this, &CDirWatcher::slotFinderFinished );
+    connect( fFinder, &CFileFinder::sigDirFinished, this, &CDirWatcher::slotAddDir );
+    connect( fFinder, &CFileFinder::sigDirRemoved, this, &CDirWatcher::slotDirRemoved );
+    connect( fFinder, &CFileFinder::sigFileChanged, this, &CDirWatcher::slotFileChanged );
+}
+
+CDirWatcher::~CDirWatcher()
+{
+#ifdef Q_OS_LINUX
+    if ( fInotifyFD >= 0 )
+        ::close( fInotifyFD );
+#endif
+}
+
+void CDirWatcher::start()
+{
+    fWatching = true;
+    flushPendingWatches();
+    if ( !fChangedDirs.isEmpty() )
+        fTimer->start();   // files that changed while the scan hashed them
+}
+
+void CDirWatcher::stop()
+{
+    fWatching = false;
+    fTimer->stop();
+    fChangedDirs.clear();
+    if ( fRescanning )
+        fFinder->slotStop();
+}
+
+void CDirWatcher::clear()
+{
+    stop();
+    fPendingWatches.clear();
+    fWatched.clear();
+    removeAllWatches();
+}
+
+void CDirWatcher::slotAddDir( const QString &dirName )
+{
+    if ( fWatched.contains( dirName ) )
+        return;
+    fWatched.insert( dirName );
+    fPendingWatches << dirName;
+    if ( fWatching && !fRescanning )
+        flushPendingWatches();
+}
+
+void CDirWatcher::slotDirRemoved( const QString &dirName )
+{
+    auto prefix = dirName + "/";
+    QStringList toRemove;
+    for ( auto ii = fWatched.begin(); ii != fWatched.end(); )
+    {
+        if ( ( *ii == dirName ) || ( *ii ).startsWith( prefix ) )
+        {
+            toRemove << *ii;
+            ii = fWatched.erase( ii );
+        }
+        else
+            ++ii;
+    }
+    if ( !toRemove.isEmpty() )
+        removeWatches( toRemove );
+}
+
+void CDirWatcher::slotFileChanged( const QString &fileName )
+{
+    // also kept while the first scan runs, they are rescanned once watching starts
+    fChangedDirs.insert( QFileInfo( fileName ).path() );
+    if ( fWatching )
+        fTimer->start();
+}
+
+void CDirWatcher::flushPendingWatches()
+{
+    if ( fPendingWatches.isEmpty() )
+        return;
+
+    auto failed = addWatches( fPendingWatches );
+    if ( !failed.isEmpty() )
+        qWarning() << "Could not watch" << failed.count() << "directories, the system limit on watches may have been reached";
+    fPendingWatches.clear();
+}
+
+QStringList CDirWatcher::addWatches( const QStringList &dirs )
+{
+#ifdef Q_OS_LINUX
+    if ( fInotifyFD >= 0 )
+    {
+        QStringList failed;
+        for ( auto &&ii : dirs )
+        {
+            auto wd = inotify_add_watch( fInotifyFD, QFile::encodeName( ii ).constData(), sWatchMask );
+            if ( wd < 0 )
+            {
+                failed << ii;
+                continue;
+            }
+            fDirsByWatch[ wd ] = ii;
+            fWatchesByDir[ ii ] = wd;
+        }
+        return failed;
+    }
+#endif
+    return fWatcher->addPaths( dirs );
+}
+
+void CDirWatcher::removeWatches( const QStringList &dirs )
+{
+#ifdef Q_OS_LINUX
+    if ( fInotifyFD >= 0 )
+    {
+        for ( auto &&ii : dirs )
+        {
+            auto pos = fWatchesByDir.find( ii );
+            if ( pos == fWatchesByDir.end() )
+                continue;
+            inotify_rm_watch( fInotifyFD, pos.value() );
+            fDirsByWatch.remove( pos.value() );
+            fWatchesByDir.erase( pos );
+        }
+        return;
+    }
+#endif
+    fWatcher->removePaths( dirs );
+}
+
+void CDirWatcher::removeAllWatches()
+{
+    auto dirs = ( fInotifyFD >= 0 ) ? fWatchesByDir.keys() : fWatcher->directories();
+    if ( !dirs.isEmpty() )
+        removeWatches( dirs );
+}
+
+void CDirWatcher::slotReadInotify()
+{
+#ifdef Q_OS_LINUX
+    alignas( struct inotify_event ) char buffer[ 64 * ( sizeof( struct inotify_event ) + NAME_MAX + 1 ) ];
+    while ( true )
+    {
+        auto len = ::read( fInotifyFD, buffer, sizeof( buffer ) );
+        if ( len <= 0 )
+            break;   // EAGAIN once every queued event is read
+
+        for ( auto ptr = buffer; ptr < buffer + len; )
+        {
+            auto event = reinterpret_cast< const struct inotify_event * >( ptr );
+            ptr += sizeof( struct inotify_event ) + event->len;
+
+            if ( event->mask & IN_Q_OVERFLOW )
+            {
+                // events were lost, any watched directory may have changed
+                for ( auto &&ii : fDirsByWatch )
+                    slotDirectoryChanged( ii );
+                continue;
+            }
+
+            auto pos = fDirsByWatch.find( event->wd );
+            if ( pos == fDirsByWatch.end() )
+                continue;
+            auto dirName = pos.value();
+            if ( event->mask & IN_IGNORED )
+            {
+                // the watch is gone, removed here or because the directory was deleted
+                fWatchesByDir.remove( dirName );
+                fDirsByWatch.erase( pos );
+                continue;
+            }
+            slotDirectoryChanged( dirName );
+        }
+    }
+#endif
+}
+
+void CDirWatcher::slotDirectoryChanged( const QString &dirName )
+{
+    if ( !fWatching )
+        return;
+    fChangedDirs.insert( dirName );
+    fTimer->start();   // restarts the coalescing window
+}
+
+void CDirWatcher::slotRescan()
+{
+    if ( !fWatching || fChangedDirs.isEmpty() )
+        return;
+
+    if ( fRescanning )
+    {
+        fTimer->start();   // try again after the current rescan completes
+        return;
+    }
+
+    auto dirs = fChangedDirs.values();
+    fChangedDirs.clear();
+
+    fRescanning = true;
+    emit sigRescanStarted( dirs );
+    fFinder->setDirsToRescan( dirs );
+    CMainWindow::threadPool()->start( fFinder );
+}
+
+void CDirWatcher::slotFinderFinished()
+{
+    if ( !fRescanning )
+        return;
+
+    fRescanning = false;
+    if ( fWatching )
+        flushPendingWatches();
+    emit sigRescanFinished();
+
+    if ( !fChangedDirs.isEmpty() )
+        fTimer->start();
+}
@@ -0,0 +1,69 @@
+#ifndef DIRWATCHER_H
+#define DIRWATCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QSocketNotifier;
+class QTimer;
+class CFileFinder;
+
+// Keeps the results current after a scan finishes
+// Every scanned directory is watched, change notifications are coalesced and only the changed directories are
+// re-enumerated by the finder, which hashes new or modified files and reports deleted ones
+// On Linux the directories are watched with inotify directly, QFileSystemWatcher does not ask for IN_CLOSE_WRITE so a
+// file rewritten in place, or still being written when it was created, would never be hashed again
+// Elsewhere QFileSystemWatcher is used, it only reports a directory when files are added, removed or renamed,
+// a file rewritten in place is only picked up once its directory changes or the next full scan
+// Files that changed while they were being hashed have their directory queued again
+class CDirWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    CDirWatcher( CFileFinder *finder, QObject *parent );
+    virtual ~CDirWatcher() override;
+
+    void start();
+    void stop();
+    void clear();
+    bool isWatching() const { return fWatching; }
+
+public Q_SLOTS:
+    void slotAddDir( const QString &dirName );
+    void slotDirRemoved( const QString &dirName );
+    void slotFileChanged( const QString &fileName );
+
+Q_SIGNALS:
+    void sigRescanStarted( const QStringList &dirs );
+    void sigRescanFinished();
+
+private Q_SLOTS:
+    void slotDirectoryChanged( const QString &dirName );
+    void slotRescan();
+    void slotFinderFinished();
+    void slotReadInotify();
+
+private:
+    void flushPendingWatches();
+    QStringList addWatches( const QStringList &dirs );   // returns the directories that could not be watched
+    void removeWatches( const QStringList &dirs );
+    void removeAllWatches();
+
+    CFileFinder *fFinder{ nullptr };
+    QFileSystemWatcher *fWatcher{ nullptr };
+    int fInotifyFD{ -1 };   // only on Linux, -1 falls back to fWatcher
+    QSocketNotifier *fInotifyNotifier{ nullptr };
+    QHash< int, QString > fDirsByWatch;
+    QHash< QString, int > fWatchesByDir;
+    QTimer *fTimer{ nullptr };
+    QSet< QString > fChangedDirs;
+    QStringList fPendingWatches;
+    QSet< QString > fWatched;
+    bool fWatching{ false };
+    bool fRescanning{ false };
+};
+
+#endif
@@ -0,0 +1,726 @@
+#include "DupeModel.h"
+#include "IconLoader.h"
+
+#include "SABUtils/FileUtils.h"
+
+#include <QBrush>
+#include <QDateTime>
+#include <QFontDatabase>
+#include <algorithm>
+
+constexpr int sFetchBatch = 1000;
+constexpr size_t sNoGroup = ~size_t( 0 );
+
+CDupeModel::CDupeModel( QObject *parent ) :
+    QAbstractItemModel( parent )
+{
+}
+
+void CDupeModel::clear( const QString &rootDir )
+{
+    beginResetModel();
+    fRootDir = QDir( rootDir );
+    fPaths.clear();
+    fGroups.clear();
+    fArena.release();   // the files of every group
+    fGroupsByDigest.clear();
+    fGroupsByFile.clear();
+    fRows.clear();
+    fTextSortKeys.clear();
+    fFetchedRows = 0;
+    fSortColumn = -1;   // unsorted until the view asks, so groups found while scanning are appended cheaply
+    endResetModel();
+}
+
+void CDupeModel::setIconLoader( CIconLoader *iconLoader )
+{
+    if ( fIconLoader )
+        disconnect( fIconLoader, nullptr, this, nullptr );
+    fIconLoader = iconLoader;
+    if ( fIconLoader )
+        connect( fIconLoader, &CIconLoader::sigIconReady, this, &CDupeModel::slotIconReady );
+}
+
+void CDupeModel::slotIconReady( const QString &fileName )
+{
+    auto id = fPaths.findFile( fileName );
+    auto groupNum = groupForFile( fileName );
+    if ( !id.has_value() || !groupNum.has_value() )
+        return;
+
+    auto &&group = fGroups[ groupNum.value() ];
+    if ( !isFetched( group ) )
+        return;
+
+    auto groupIdx = index( group.fRow, eFileName );
+    if ( group.fFiles.front().fPath == id.value() )
+        emit dataChanged( groupIdx, groupIdx, { Qt::DecorationRole } );
+
+    for ( int ii = 0; ii < group.fFetchedFiles; ++ii )
+    {
+        if ( group.fFiles[ ii ].fPath != id.value() )
+            continue;
+        auto fileIdx = index( ii, eFileName, groupIdx );
+        emit dataChanged( fileIdx, fileIdx, { Qt::DecorationRole } );
+        break;
+    }
+}
+
+void CDupeModel::setShowDupesOnly( bool showDupesOnly )
+{
+    if ( showDupesOnly == fShowDupesOnly )
+        return;
+
+    beginResetModel();
+    fShowDupesOnly = showDupesOnly;
+    layoutRows();
+    endResetModel();
+}
+
+void CDupeModel::beginLoad()
+{
+    if ( fLoading )
+        return;
+    beginResetModel();
+    fLoading = true;
+}
+
+void CDupeModel::endLoad()
+{
+    if ( !fLoading )
+        return;
+    fLoading = false;
+    layoutRows();
+    endResetModel();
+}
+
+bool CDupeModel::isVisible( const SGroup &group ) const
+{
+    return group.fFiles.size() > ( fShowDupesOnly ? 1U : 0U );
+}
+
+void CDupeModel::layoutRows()
+{
+    fRows.clear();
+    for ( size_t ii = 0; ii < fGroups.size(); ++ii )
+    {
+        fGroups[ ii ].fRow = -1;
+        fGroups[ ii ].fFetchedFiles = 0;
+        if ( isVisible( fGroups[ ii ] ) )
+            fRows.push_back( ii );
+    }
+    sortRows();
+    renumberRows( 0 );
+    fFetchedRows = 0;
+}
+
+void CDupeModel::renumberRows( int from )
+{
+    for ( int ii = from; ii < static_cast< int >( fRows.size() ); ++ii )
+        fGroups[ fRows[ ii ] ].fRow = ii;
+}
+
+qint64 CDupeModel::sortKey( const SGroup &group ) const
+{
+    switch ( fSortColumn )
+    {
+        case eTimestamp:
+            return group.fFiles.front().fMTime;
+        case eCount:
+            return static_cast< qint64 >( group.fFiles.size() );
+        case eSize:
+            return group.fFiles.front().fSize;
+        default:
+            return 0;
+    }
+}
+
+bool CDupeModel::isNumericSort() const
+{
+    return ( fSortColumn == eTimestamp ) || ( fSortColumn == eCount ) || ( fSortColumn == eSize );
+}
+
+QString CDupeModel::textSortKey( const SGroup &group ) const
+{
+    if ( fSortColumn == eMD5 )
+        return group.fDigest.toHex();
+    return fRootDir.relativeFilePath( filePath( group.fFiles.front() ) ).toCaseFolded();
+}
+
+void CDupeModel::updateTextSortKey( size_t groupNum )
+{
+    if ( ( fSortColumn < 0 ) || isNumericSort() )
+        return;
+
+    if ( fTextSortKeys.size() < fGroups.size() )
+        fTextSortKeys.resize( fGroups.size() );
+    auto &&group = fGroups[ groupNum ];
+    fTextSortKeys[ groupNum ] = group.fFiles.empty() ? QString() : textSortKey( group );
+}
+
+template< typename T >
+static void sortByKeys( std::vector< std::pair< T, size_t > > &keys, Qt::SortOrder order )
+{
+    // the index is the tie breaker, so equal keys keep a stable order in both directions
+    if ( order == Qt::AscendingOrder )
+        std::sort( keys.begin(), keys.end() );
+    else
+        std::sort( keys.begin(), keys.end(), []( const std::pair< T, size_t > &lhs, const std::pair< T, size_t > &rhs ) { return ( lhs.first != rhs.first ) ? ( rhs.first < lhs.first ) : ( lhs.second < rhs.second ); } );
+}
+
+void CDupeModel::sortFiles( SGroup &group ) const
+{
+    if ( ( fSortColumn != eFileName ) && ( fSortColumn != eTimestamp ) )
+        return;   // every file in a group has the same size, count and MD5
+
+    if ( fSortColumn == eTimestamp )
+    {
+        std::vector< std::pair< qint64, size_t > > keys;
+        keys.reserve( group.fFiles.size() );
+        for ( size_t ii = 0; ii < group.fFiles.size(); ++ii )
+            keys.emplace_back( group.fFiles[ ii ].fMTime, ii );
+        sortByKeys( keys, fSortOrder );
+        std::vector< SFile > files;
+        files.reserve( keys.size() );
+        for ( auto &&ii : keys )
+            files.push_back( group.fFiles[ ii.second ] );
+        std::copy( files.begin(), files.end(), group.fFiles.begin() );
+    }
+    else
+    {
+        std::vector< std::pair< QString, size_t > > keys;
+        keys.reserve( group.fFiles.size() );
+        for ( size_t ii = 0; ii < group.fFiles.size(); ++ii )
+            keys.emplace_back( filePath( group.fFiles[ ii ] ).toCaseFolded(), ii );
+        sortByKeys( keys, fSortOrder );
+        std::vector< SFile > files;
+        files.reserve( keys.size() );
+        for ( auto &&ii : keys )
+            files.push_back( group.fFiles[ ii.second ] );
+        std::copy( files.begin(), files.end(), group.fFiles.begin() );
+    }
+}
+
+void CDupeModel::sortRows()
+{
+    if ( fSortColumn < 0 )
+        return;
+
+    for ( auto &&ii : fRows )
+        sortFiles( fGroups[ ii ] );
+
+    // the keys are pulled out of the groups once, the sort itself only touches the contiguous key array
+    if ( isNumericSort() )
+    {
+        std::vector< std::pair< qint64, size_t > > keys;
+        keys.reserve( fRows.size() );
+        for ( auto &&ii : fRows )
+            keys.emplace_back( sortKey( fGroups[ ii ] ), ii );
+        sortByKeys( keys, fSortOrder );
+        for ( size_t ii = 0; ii < keys.size(); ++ii )
+            fRows[ ii ] = keys[ ii ].second;
+    }
+    else
+    {
+        std::vector< std::pair< QString, size_t > > keys;
+        keys.reserve( fRows.size() );
+        for ( auto &&ii : fRows )
+        {
+            updateTextSortKey( ii );
+            keys.emplace_back( fTextSortKeys[ ii ], ii );
+        }
+        sortByKeys( keys, fSortOrder );
+        for ( size_t ii = 0; ii < keys.size(); ++ii )
+            fRows[ ii ] = keys[ ii ].second;
+    }
+}
+
+int CDupeModel::sortedRow( size_t groupNum ) const
+{
+    if ( fSortColumn < 0 )
+        return static_cast< int >( fRows.size() );
+
+    // fRows is kept sorted by the key, every group whose key changes is moved to its new position
+    auto pos = std::upper_bound( fRows.begin(), fRows.end(), groupNum, [ this ]( size_t lhs, size_t rhs ) { return sortsBefore( lhs, rhs ); } );
+    return static_cast< int >( pos - fRows.begin() );
+}
+
+bool CDupeModel::sortsBefore( size_t lhs, size_t rhs ) const
+{
+    if ( fSortOrder != Qt::AscendingOrder )
+        std::swap( lhs, rhs );
+    if ( isNumericSort() )
+        return sortKey( fGroups[ lhs ] ) < sortKey( fGroups[ rhs ] );
+    return fTextSortKeys[ lhs ] < fTextSortKeys[ rhs ];
+}
+
+bool CDupeModel::isInSortedPosition( size_t groupNum ) const
+{
+    if ( fSortColumn < 0 )
+        return true;
+
+    auto row = fGroups[ groupNum ].fRow;
+    if ( ( row > 0 ) && sortsBefore( groupNum, fRows[ row - 1 ] ) )
+        return false;
+    if ( ( ( row + 1 ) < static_cast< int >( fRows.size() ) ) && sortsBefore( fRows[ row + 1 ], groupNum ) )
+        return false;
+    return true;
+}
+
+void CDupeModel::sort( int column, Qt::SortOrder order )
+{
+    fSortColumn = column;
+    fSortOrder = order;
+    if ( fLoading )
+        return;
+
+    beginResetModel();
+    layoutRows();
+    endResetModel();
+}
+
+void CDupeModel::updateVisibility( size_t groupNum )
+{
+    if ( fLoading )
+        return;
+
+    updateTextSortKey( groupNum );
+    auto &&group = fGroups[ groupNum ];
+    auto visible = isVisible( group );
+    if ( visible && ( group.fRow >= 0 ) && !isInSortedPosition( groupNum ) )
+        hideGroup( groupNum );   // its key changed, it is shown again at its new position
+
+    if ( visible && ( group.fRow < 0 ) )
+        showGroup( groupNum );
+    else if ( !visible && ( group.fRow >= 0 ) )
+        hideGroup( groupNum );
+    else if ( visible && isFetched( group ) )
+        emit dataChanged( index( group.fRow, 0 ), index( group.fRow, eNumColumns - 1 ) );
+}
+
+void CDupeModel::showGroup( size_t groupNum )
+{
+    // groups go to their sorted position, they are only reported if it is within the rows the view has
+    auto &&group = fGroups[ groupNum ];
+    auto row = sortedRow( groupNum );
+    bool report = ( row < fFetchedRows ) || ( fFetchedRows == static_cast< int >( fRows.size() ) );
+    group.fFetchedFiles = 0;
+    if ( report )
+        beginInsertRows( QModelIndex(), row, row );
+    fRows.insert( fRows.begin() + row, groupNum );
+    renumberRows( row );
+    if ( report )
+    {
+        fFetchedRows++;
+        endInsertRows();
+    }
+}
+
+void CDupeModel::hideGroup( size_t groupNum )
+{
+    auto &&group = fGroups[ groupNum ];
+    auto row = group.fRow;
+    bool report = isFetched( group );
+    if ( report )
+        beginRemoveRows( QModelIndex(), row, row );
+    fRows.erase( fRows.begin() + row );
+    group.fRow = -1;
+    group.fFetchedFiles = 0;
+    if ( report )
+    {
+        fFetchedRows--;
+        endRemoveRows();
+    }
+    renumberRows( row );
+}
+
+std::optional< size_t > CDupeModel::addFile( const SDigest &digest, const SFileMeta &meta, bool deleteFile )
+{
+    auto id = fPaths.addFile( meta.fPath );
+    if ( id >= fGroupsByFile.size() )
+        fGroupsByFile.resize( id + 1, sNoGroup );
+    if ( fGroupsByFile[ id ] != sNoGroup )
+        return {};
+
+    size_t groupNum = 0;
+    auto pos = fGroupsByDigest.find( digest );
+    if ( !pos.has_value() )
+    {
+        groupNum = fGroups.size();
+        fGroups.emplace_back();
+        fGroups.back().fDigest = digest;
+        fGroupsByDigest.insert( digest, static_cast< quint32 >( groupNum ) );
+    }
+    else
+        groupNum = pos.value();
+
+    auto &&group = fGroups[ groupNum ];
+    auto fileNum = static_cast< int >( group.fFiles.size() );
+    bool report = !fLoading && isFetched( group ) && ( group.fFetchedFiles == fileNum );
+    if ( report )
+        beginInsertRows( index( group.fRow, 0 ), fileNum, fileNum );
+    group.fFiles.push_back( fArena, { id, meta.fSize, meta.fMTime, meta.fCTime, deleteFile } );
+    if ( report )
+    {
+        group.fFetchedFiles++;
+        endInsertRows();
+    }
+    fGroupsByFile[ id ] = groupNum;
+
+    updateVisibility( groupNum );
+    return groupNum;
+}
+
+std::optional< SFileMeta > CDupeModel::removeFile( const QString &fileName )
+{
+    auto id = fPaths.findFile( fileName );
+    auto groupNum = groupForFile( fileName );
+    if ( !id.has_value() || !groupNum.has_value() )
+        return {};
+    fGroupsByFile[ id.value() ] = sNoGroup;
+
+    auto &&group = fGroups[ groupNum.value() ];
+    auto file = std::find_if( group.fFiles.begin(), group.fFiles.end(), [ &id ]( const SFile &ii ) { return ii.fPath == id.value(); } );
+    if ( file == group.fFiles.end() )
+        return {};
+
+    auto retVal = fileMeta( *file );
+    auto fileNum = static_cast< int >( file - group.fFiles.begin() );
+    bool report = !fLoading && isFetched( group ) && ( fileNum < group.fFetchedFiles );
+    if ( report )
+        beginRemoveRows( index( group.fRow, 0 ), fileNum, fileNum );
+    group.fFiles.erase( file );
+    if ( report )
+    {
+        group.fFetchedFiles--;
+        endRemoveRows();
+    }
+
+    updateVisibility( groupNum.value() );
+    return retVal;
+}
+
+std::optional< size_t > CDupeModel::groupForFile( const QString &fileName ) const
+{
+    auto id = fPaths.findFile( fileName );
+    if ( !id.has_value() )
+        return {};
+    return groupForFileID( id.value() );
+}
+
+std::optional< size_t > CDupeModel::groupForFileID( CPathStore::TID file ) const
+{
+    if ( ( file >= fGroupsByFile.size() ) || ( fGroupsByFile[ file ] == sNoGroup ) )
+        return {};
+    return fGroupsByFile[ file ];
+}
+
+QStringList CDupeModel::filesUnder( const QString &dirName ) const
+{
+    QStringList retVal;
+    auto dir = fPaths.findDir( dirName );
+    if ( !dir.has_value() )
+        return retVal;
+
+    for ( auto &&ii : fPaths.filesUnder( dir.value() ) )
+    {
+        if ( ( ii < fGroupsByFile.size() ) && ( fGroupsByFile[ ii ] != sNoGroup ) )
+            retVal << fPaths.path( ii );
+    }
+    return retVal;
+}
+
+SFileMeta CDupeModel::fileMeta( const SFile &file ) const
+{
+    SFileMeta retVal;
+    retVal.fPath = filePath( file );
+    retVal.fSize = file.fSize;
+    retVal.fMTime = file.fMTime;
+    retVal.fCTime = file.fCTime;
+    return retVal;
+}
+
+void CDupeModel::setFilesToDelete( size_t groupNum, const std::vector< size_t > &filesToDelete )
+{
+    auto &&group = fGroups[ groupNum ];
+    for ( auto &&ii : group.fFiles )
+        ii.fDelete = false;
+    for ( auto &&ii : filesToDelete )
+        group.fFiles[ ii ].fDelete = true;
+
+    if ( !fLoading && isFetched( group ) && ( group.fFetchedFiles > 0 ) )
+    {
+        auto parentIdx = index( group.fRow, 0 );
+        emit dataChanged( index( 0, 0, parentIdx ), index( group.fFetchedFiles - 1, 0, parentIdx ), { Qt::CheckStateRole, Qt::BackgroundRole } );
+    }
+}
+
+QStringList CDupeModel::filesToDelete() const
+{
+    QStringList retVal;
+    for ( auto &&ii : fRows )
+        retVal << filesToDelete( ii );
+    return retVal;
+}
+
+QStringList CDupeModel::filesToDelete( size_t groupNum ) const
+{
+    QStringList retVal;
+    auto &&group = fGroups[ groupNum ];
+    if ( group.fFiles.size() < 2 )
+        return retVal;
+    for ( auto &&ii : group.fFiles )
+    {
+        if ( ii.fDelete )
+            retVal << filePath( ii );
+    }
+    return retVal;
+}
+
+std::optional< size_t > CDupeModel::groupForIndex( const QModelIndex &index ) const
+{
+    if ( !index.isValid() )
+        return {};
+    if ( index.internalId() != 0 )
+        return static_cast< size_t >( index.internalId() - 1 );
+    return fRows[ index.row() ];
+}
+
+QString CDupeModel::filePath( const QModelIndex &index ) const
+{
+    auto groupNum = groupForIndex( index );
+    if ( !groupNum.has_value() )
+        return {};
+
+    auto &&group = fGroups[ groupNum.value() ];
+    if ( group.fFiles.empty() )
+        return {};
+    auto fileNum = ( index.internalId() != 0 ) ? index.row() : 0;
+    return filePath( group.fFiles[ fileNum ] );
+}
+
+QModelIndex CDupeModel::index( int row, int column, const QModelIndex &parent ) const
+{
+    if ( ( row < 0 ) || ( column < 0 ) || ( column >= eNumColumns ) )
+        return {};
+
+    if ( !parent.isValid() )
+    {
+        if ( row >= fFetchedRows )
+            return {};
+        return createIndex( row, column, quintptr( 0 ) );
+    }
+
+    if ( parent.internalId() != 0 )
+        return {};   // files have no children
+    if ( parent.row() >= fFetchedRows )
+        return {};
+
+    auto groupNum = fRows[ parent.row() ];
+    if ( row >= fGroups[ groupNum ].fFetchedFiles )
+        return {};
+    return createIndex( row, column, quintptr( groupNum + 1 ) );
+}
+
+QModelIndex CDupeModel::parent( const QModelIndex &child ) const
+{
+    if ( !child.isValid() || ( child.internalId() == 0 ) )
+        return {};
+
+    auto &&group = fGroups[ child.internalId() - 1 ];
+    if ( group.fRow < 0 )
+        return {};
+    return createIndex( group.fRow, 0, quintptr( 0 ) );
+}
+
+int CDupeModel::rowCount( const QModelIndex &parent ) const
+{
+    if ( fLoading )
+        return 0;
+    if ( !parent.isValid() )
+        return fFetchedRows;
+    if ( ( parent.internalId() != 0 ) || ( parent.column() != 0 ) )
+        return 0;
+    return fGroups[ fRows[ parent.row() ] ].fFetchedFiles;
+}
+
+int CDupeModel::columnCount( const QModelIndex & /*parent*/ ) const
+{
+    return eNumColumns;
+}
+
+bool CDupeModel::hasChildren( const QModelIndex &parent ) const
+{
+    if ( fLoading )
+        return false;
+    if ( !parent.isValid() )
+        return !fRows.empty();
+    if ( ( parent.internalId() != 0 ) || ( parent.column() != 0 ) )
+        return false;
+    return !fGroups[ fRows[ parent.row() ] ].fFiles.empty();
+}
+
+bool CDupeModel::canFetchMore( const QModelIndex &parent ) const
+{
+    if ( fLoading )
+        return false;
+    if ( !parent.isValid() )
+        return fFetchedRows < static_cast< int >( fRows.size() );
+    if ( parent.internalId() != 0 )
+        return false;
+
+    auto &&group = fGroups[ fRows[ parent.row() ] ];
+    return group.fFetchedFiles < static_cast< int >( group.fFiles.size() );
+}
+
+void CDupeModel::fetchMore( const QModelIndex &parent )
+{
+    if ( !canFetchMore( parent ) )
+        return;
+
+    if ( !parent.isValid() )
+    {
+        auto num = std::min( sFetchBatch, static_cast< int >( fRows.size() ) - fFetchedRows );
+        beginInsertRows( QModelIndex(), fFetchedRows, fFetchedRows + num - 1 );
+        fFetchedRows += num;
+        endInsertRows();
+        return;
+    }
+
+    auto &&group = fGroups[ fRows[ parent.row() ] ];
+    auto num = std::min( sFetchBatch, static_cast< int >( group.fFiles.size() ) - group.fFetchedFiles );
+    beginInsertRows( parent, group.fFetchedFiles, group.fFetchedFiles + num - 1 );
+    group.fFetchedFiles += num;
+    endInsertRows();
+}
+
+QVariant CDupeModel::data( const QModelIndex &index, int role ) const
+{
+    auto groupNum = groupForIndex( index );
+    if ( !groupNum.has_value() )
+        return {};
+
+    auto &&group = fGroups[ groupNum.value() ];
+    if ( group.fFiles.empty() )
+        return {};
+
+    if ( index.internalId() == 0 )
+        return groupData( group, index.column(), role );
+    if ( index.row() >= static_cast< int >( group.fFiles.size() ) )
+        return {};
+    return fileData( group, group.fFiles[ index.row() ], index.column(), role );
+}
+
+QVariant CDupeModel::groupData( const SGroup &group, int column, int role ) const
+{
+    auto &&first = group.fFiles.front();
+    switch ( role )
+    {
+        case Qt::DisplayRole:
+            switch ( column )
+            {
+                case eFileName:
+                    return fRootDir.relativeFilePath( filePath( first ) );
+                case eCount:
+                    return QString::number( group.fFiles.size() );
+                case eSize:
+                    return NSABUtils::NFileUtils::byteSizeString( first.fSize );
+                case eMD5:
+                    return group.fDigest.toHex();
+                default:
+                    return {};
+            }
+        case Qt::DecorationRole:
+            if ( fIconLoader && ( column == eFileName ) && ( group.fFiles.size() > 1 ) )
+                return fIconLoader->icon( fileMeta( first ) );
+            return {};
+        case Qt::TextAlignmentRole:
+            if ( ( column == eSize ) || ( column == eMD5 ) )
+                return static_cast< int >( Qt::AlignmentFlag::AlignRight | Qt::AlignmentFlag::AlignVCenter );
+            return {};
+        case Qt::FontRole:
+            if ( column == eMD5 )
+                return QFontDatabase::systemFont( QFontDatabase::FixedFont );
+            return {};
+        default:
+            return {};
+    }
+}
+
+QVariant CDupeModel::fileData( const SGroup &group, const SFile &file, int column, int role ) const
+{
+    switch ( role )
+    {
+        case Qt::DisplayRole:
+            if ( column == eFileName )
+                return fRootDir.relativeFilePath( filePath( file ) );
+            if ( column == eTimestamp )
+                return QDateTime::fromMSecsSinceEpoch( file.fMTime ).toString();
+            return {};
+        case Qt::DecorationRole:
+            if ( fIconLoader && ( column == eFileName ) )
+                return fIconLoader->icon( fileMeta( file ) );
+            return {};
+        case Qt::TextAlignmentRole:
+            if ( column == eTimestamp )
+                return static_cast< int >( Qt::AlignmentFlag::AlignRight | Qt::AlignmentFlag::AlignVCenter );
+            return {};
+        case Qt::CheckStateRole:
+            if ( ( column == eFileName ) && ( group.fFiles.size() > 1 ) )
+                return file.fDelete ? Qt::Checked : Qt::Unchecked;
+            return {};
+        case Qt::BackgroundRole:
+            if ( ( column == eFileName ) && file.fDelete && ( group.fFiles.size() > 1 ) )
+                return QBrush( Qt::red );
+            return {};
+        default:
+            return {};
+    }
+}
+
+bool CDupeModel::setData( const QModelIndex &index, const QVariant &value, int role )
+{
+    if ( ( role != Qt::CheckStateRole ) || !index.isValid() || ( index.internalId() == 0 ) || ( index.column() != eFileName ) )
+        return false;
+
+    auto &&group = fGroups[ index.internalId() - 1 ];
+    if ( index.row() >= static_cast< int >( group.fFiles.size() ) )
+        return false;
+
+    group.fFiles[ index.row() ].fDelete = static_cast< Qt::CheckState >( value.toInt() ) == Qt::Checked;
+    emit dataChanged( index, index, { Qt::CheckStateRole, Qt::BackgroundRole } );
+    return true;
+}
+
+Qt::ItemFlags CDupeModel::flags( const QModelIndex &index ) const
+{
+    auto retVal = QAbstractItemModel::flags( index );
+    if ( !index.isValid() || ( index.internalId() == 0 ) || ( index.column() != eFileName ) )
+        return retVal;
+
+    if ( fGroups[ index.internalId() - 1 ].fFiles.size() > 1 )
+        retVal |= Qt::ItemIsUserCheckable;
+    return retVal;
+}
+
+QVariant CDupeModel::headerData( int section, Qt::Orientation orientation, int role ) const
+{
+    if ( ( orientation != Qt::Horizontal ) || ( role != Qt::DisplayRole ) )
+        return QAbstractItemModel::headerData( section, orientation, role );
+
+    switch ( section )
+    {
+        case eFileName:
+            return tr( "FileName" );
+        case eTimestamp:
+            return tr( "Timestamp" );
+        case eCount:
+            return tr( "Count" );
+        case eSize:
+            return tr( "Size" );
+        case eMD5:
+            return tr( "MD5" );
+        default:
+            return {};
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef DUPEMODEL_H
+#define DUPEMODEL_H
+
+#include "KeepPolicy.h"
+#include "PathStore.h"
+#include "DigestIndex.h"
+#include "ScanArena.h"
+
+#include <QAbstractItemModel>
+#include <QDir>
+#include <optional>
+#include <vector>
+
+class CIconLoader;
+
+// The duplicate groups, one top level row per MD5 with a child row per file
+// Rows are handed to the view in batches through canFetchMore/fetchMore, top level rows as the view scrolls
+// and child rows when a group is expanded, so the cost of a result set is independent of its size
+class CDupeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    enum EColumns
+    {
+        eFileName,
+        eTimestamp,
+        eCount,
+        eSize,
+        eMD5,
+        eNumColumns
+    };
+
+    struct SFile
+    {
+        CPathStore::TID fPath{ CPathStore::sInvalid };
+        qint64 fSize{ 0 };
+        qint64 fMTime{ 0 };
+        qint64 fCTime{ 0 };
+        bool fDelete{ false };
+    };
+
+    CDupeModel( QObject *parent );
+
+    void clear( const QString &rootDir );
+    QString rootDir() const { return fRootDir.absolutePath(); }
+    void setIconLoader( CIconLoader *iconLoader );
+
+    void setShowDupesOnly( bool showDupesOnly );
+    bool showDupesOnly() const { return fShowDupesOnly; }
+
+    // while loading no rows are reported to the view, all rows are laid out again by endLoad
+    void beginLoad();
+    void endLoad();
+
+    std::optional< size_t > addFile( const SDigest &digest, const SFileMeta &meta, bool deleteFile = false );   // no value when the file is already known
+    std::optional< SFileMeta > removeFile( const QString &fileName );
+    bool hasFile( const QString &fileName ) const { return groupForFile( fileName ).has_value(); }
+    std::optional< size_t > groupForFile( const QString &fileName ) const;
+    std::optional< size_t > groupForFileID( CPathStore::TID file ) const;
+    const CPathStore &paths() const { return fPaths; }
+    QStringList filesUnder( const QString &dirName ) const;
+
+    size_t numGroups() const { return fGroups.size(); }
+    size_t numVisibleGroups() const { return fRows.size(); }
+    const SDigest &groupDigest( size_t group ) const { return fGroups[ group ].fDigest; }
+    const CArenaArray< SFile > &groupFiles( size_t group ) const { return fGroups[ group ].fFiles; }
+    SFileMeta fileMeta( const SFile &file ) const;   // with the absolute path
+    QString filePath( const SFile &file ) const { return fPaths.path( file.fPath ); }
+    int groupFileCount( size_t group ) const { return static_cast< int >( fGroups[ group ].fFiles.size() ); }
+    void setFilesToDelete( size_t group, const std::vector< size_t > &filesToDelete );
+    QStringList filesToDelete() const;   // of the visible groups
+    QStringList filesToDelete( size_t group ) const;
+
+    std::optional< size_t > groupForIndex( const QModelIndex &index ) const;
+    QString filePath( const QModelIndex &index ) const;
+
+    QModelIndex index( int row, int column, const QModelIndex &parent = QModelIndex() ) const override;
+    QModelIndex parent( const QModelIndex &child ) const override;
+    int rowCount( const QModelIndex &parent = QModelIndex() ) const override;
+    int columnCount( const QModelIndex &parent = QModelIndex() ) const override;
+    bool hasChildren( const QModelIndex &parent = QModelIndex() ) const override;
+    bool canFetchMore( const QModelIndex &parent ) const override;
+    void fetchMore( const QModelIndex &parent ) override;
+    QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const override;
+    bool setData( const QModelIndex &index, const QVariant &value, int role = Qt::EditRole ) override;
+    Qt::ItemFlags flags( const QModelIndex &index ) const override;
+    QVariant headerData( int section, Qt::Orientation orientation, int role = Qt::DisplayRole ) const override;
+    void sort( int column, Qt::SortOrder order = Qt::AscendingOrder ) override;
+
+public Q_SLOTS:
+    void slotIconReady( const QString &fileName );
+
+private:
+    struct SGroup
+    {
+        SDigest fDigest;
+        CArenaArray< SFile > fFiles;   // in fArena
+        int fFetchedFiles{ 0 };   // child rows known to the view
+        int fRow{ -1 };   // top level row, -1 when not visible
+    };
+    static_assert( std::is_trivially_destructible< SGroup >::value, "groups are dropped without being destroyed one by one" );
+
+    bool isVisible( const SGroup &group ) const;
+    bool isFetched( const SGroup &group ) const { return ( group.fRow >= 0 ) && ( group.fRow < fFetchedRows ); }
+    void updateVisibility( size_t group );
+    void showGroup( size_t group );
+    void hideGroup( size_t group );
+    void renumberRows( int from );
+    void layoutRows();
+    void sortRows();
+    void sortFiles( SGroup &group ) const;
+    int sortedRow( size_t group ) const;
+    bool isInSortedPosition( size_t group ) const;
+    bool sortsBefore( size_t lhs, size_t rhs ) const;   // by the sort key alone
+    bool isNumericSort() const;
+    qint64 sortKey( const SGroup &group ) const;
+    QString textSortKey( const SGroup &group ) const;
+    void updateTextSortKey( size_t group );
+    QVariant groupData( const SGroup &group, int column, int role ) const;
+    QVariant fileData( const SGroup &group, const SFile &file, int column, int role ) const;
+
+    QDir fRootDir;
+    CScanArena fArena;
+    CPathStore fPaths;
+    CIconLoader *fIconLoader{ nullptr };
+    std::vector< SGroup > fGroups;   // empty groups are kept so their index stays valid
+    CDigestIndex fGroupsByDigest;
+    std::vector< size_t > fGroupsByFile;   // by path id, sNoGroup when the file is not in the results
+    std::vector< size_t > fRows;   // visible groups in display order
+    std::vector< QString > fTextSortKeys;   // by group, kept current for the visible groups while sorting by a text column
+    int fFetchedRows{ 0 };   // top level rows known to the view
+    bool fShowDupesOnly{ true };
+    bool fLoading{ false };
+    int fSortColumn{ -1 };
+    Qt::SortOrder fSortOrder{ Qt::AscendingOrder };
+};
+
+#endif
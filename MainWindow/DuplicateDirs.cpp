@@ -0,0 +1,168 @@
+#include "DuplicateDirs.h"
+#include "DupeModel.h"
+#include "DigestIndex.h"
+
+#include <QCryptographicHash>
+#include <algorithm>
+
+static const QByteArray sDirPrefix( "FDDIR1" );
+constexpr size_t sMinSubsetFiles = 2;   // a single file having a copy elsewhere is already a file group
+constexpr int sMaxSubsetCandidates = 64;   // directories holding a copy of the directory's rarest file
+
+CDuplicateDirs::CDuplicateDirs( const CDupeModel *model ) :
+    fModel( model )
+{
+}
+
+void CDuplicateDirs::find()
+{
+    fGroups.clear();
+    fSubsets.clear();
+    hashDirs();
+    groupDirs();
+    findSubsets();
+    fDirs = {};
+}
+
+void CDuplicateDirs::hashDirs()
+{
+    auto &&paths = fModel->paths();
+    fDirs.clear();
+    fDirs.resize( paths.numDirs() );
+
+    for ( CPathStore::TID ii = 0; ii < paths.numFiles(); ++ii )
+    {
+        auto group = fModel->groupForFileID( ii );
+        auto dirID = paths.dirOf( ii );
+        if ( !group.has_value() || ( dirID == CPathStore::sInvalid ) )
+            continue;
+
+        auto size = fModel->groupFiles( group.value() ).front().fSize;   // every file in a group has the same size
+        auto &&dir = fDirs[ dirID ];
+        dir.fEntries.push_back( { paths.fileName( ii ), fModel->groupDigest( group.value() ), false } );
+        dir.fFileGroups.push_back( group.value() );
+        dir.fFileBytes += size;
+        dir.fNumFiles++;
+        dir.fSize += size;
+    }
+
+    // a directory's id is above its parent's, so walking down the ids finishes every subtree before its parent
+    for ( auto ii = static_cast< CPathStore::TID >( fDirs.size() ); ii-- > 0; )
+    {
+        auto &&dir = fDirs[ ii ];
+        if ( dir.fEntries.empty() )
+            continue;   // nothing below it is in the results
+
+        std::sort( dir.fEntries.begin(), dir.fEntries.end(), []( const SEntry &lhs, const SEntry &rhs ) { return ( lhs.fIsDir != rhs.fIsDir ) ? rhs.fIsDir : ( lhs.fName < rhs.fName ); } );
+        QCryptographicHash hash( QCryptographicHash::Md5 );
+        hash.addData( sDirPrefix );
+        for ( auto &&entry : dir.fEntries )
+        {
+            hash.addData( entry.fIsDir ? "D" : "F", 1 );
+            hash.addData( entry.fName.toUtf8() );
+            hash.addData( "", 1 );   // the terminating null keeps "ab"+"c" apart from "a"+"bc"
+            hash.addData( reinterpret_cast< const char * >( entry.fDigest.fBytes.data() ), SDigest::sSize );
+        }
+        dir.fDigest = SDigest::fromBytes( hash.result() );
+        dir.fHasDigest = true;
+        dir.fEntries = {};
+
+        std::sort( dir.fFileGroups.begin(), dir.fFileGroups.end() );
+        dir.fFileGroups.erase( std::unique( dir.fFileGroups.begin(), dir.fFileGroups.end() ), dir.fFileGroups.end() );
+
+        auto parentID = paths.parentOf( ii );
+        if ( parentID == CPathStore::sInvalid )
+            continue;
+        auto &&parent = fDirs[ parentID ];
+        parent.fEntries.push_back( { paths.dirName( ii ), dir.fDigest, true } );
+        parent.fNumFiles += dir.fNumFiles;
+        parent.fSize += dir.fSize;
+    }
+}
+
+void CDuplicateDirs::groupDirs()
+{
+    CDigestIndex setsByDigest;
+    std::vector< std::vector< CPathStore::TID > > sets;
+    for ( CPathStore::TID ii = 0; ii < fDirs.size(); ++ii )
+    {
+        if ( !fDirs[ ii ].fHasDigest )
+            continue;
+        auto pos = setsByDigest.find( fDirs[ ii ].fDigest );
+        if ( pos.has_value() )
+            sets[ pos.value() ].push_back( ii );
+        else
+        {
+            setsByDigest.insert( fDirs[ ii ].fDigest, static_cast< quint32 >( sets.size() ) );
+            sets.push_back( { ii } );
+        }
+    }
+
+    for ( auto &&set : sets )
+    {
+        if ( set.size() < 2 )
+            continue;
+        for ( auto &&ii : set )
+            fDirs[ ii ].fDuplicated = true;
+    }
+
+    auto &&paths = fModel->paths();
+    for ( auto &&set : sets )
+    {
+        if ( set.size() < 2 )
+            continue;
+
+        // when every copy sits in a duplicated parent, the parents' group already covers this one
+        auto nested = std::all_of( set.begin(), set.end(), [ this, &paths ]( CPathStore::TID ii ) { auto parentID = paths.parentOf( ii ); return ( parentID != CPathStore::sInvalid ) && fDirs[ parentID ].fDuplicated; } );
+        if ( nested )
+            continue;
+
+        SGroup group;
+        for ( auto &&ii : set )
+            group.fDirs.push_back( paths.dirPath( ii ) );
+        group.fNumFiles = fDirs[ set.front() ].fNumFiles;
+        group.fSize = fDirs[ set.front() ].fSize;
+        fGroups.push_back( group );
+    }
+    std::sort( fGroups.begin(), fGroups.end(), []( const SGroup &lhs, const SGroup &rhs ) { return lhs.fSize * static_cast< qint64 >( lhs.fDirs.size() ) > rhs.fSize * static_cast< qint64 >( rhs.fDirs.size() ); } );
+}
+
+void CDuplicateDirs::findSubsets()
+{
+    auto &&paths = fModel->paths();
+    for ( CPathStore::TID ii = 0; ii < fDirs.size(); ++ii )
+    {
+        auto &&dir = fDirs[ ii ];
+        if ( dir.fDuplicated || ( dir.fFileGroups.size() < sMinSubsetFiles ) )
+            continue;
+
+        // a directory containing all of this one's files holds a copy of its rarest file
+        auto rarest = *std::min_element( dir.fFileGroups.begin(), dir.fFileGroups.end(), [ this ]( size_t lhs, size_t rhs ) { return fModel->groupFileCount( lhs ) < fModel->groupFileCount( rhs ); } );
+        auto &&copies = fModel->groupFiles( rarest );
+        if ( copies.size() < 2 )
+            continue;
+
+        int numCandidates = 0;
+        std::vector< CPathStore::TID > checked;
+        for ( auto &&copy : copies )
+        {
+            auto candidateID = paths.dirOf( copy.fPath );
+            if ( ( candidateID == ii ) || ( candidateID == CPathStore::sInvalid ) || ( std::find( checked.begin(), checked.end(), candidateID ) != checked.end() ) )
+                continue;
+            if ( ++numCandidates > sMaxSubsetCandidates )
+                break;
+            checked.push_back( candidateID );
+
+            // directories with the same files under other names are reported once
+            auto &&candidate = fDirs[ candidateID ];
+            if ( ( candidate.fFileGroups.size() < dir.fFileGroups.size() ) || ( ( candidate.fFileGroups.size() == dir.fFileGroups.size() ) && ( candidateID > ii ) ) )
+                continue;
+            if ( !std::includes( candidate.fFileGroups.begin(), candidate.fFileGroups.end(), dir.fFileGroups.begin(), dir.fFileGroups.end() ) )
+                continue;
+
+            fSubsets.push_back( { paths.dirPath( ii ), paths.dirPath( candidateID ), static_cast< int >( dir.fFileGroups.size() ), dir.fFileBytes } );
+            break;
+        }
+    }
+    std::sort( fSubsets.begin(), fSubsets.end(), []( const SSubset &lhs, const SSubset &rhs ) { return lhs.fSize > rhs.fSize; } );
+}
@@ -0,0 +1,68 @@
+#ifndef DUPLICATEDIRS_H
+#define DUPLICATEDIRS_H
+
+#include "Digest.h"
+
+#include <QString>
+#include <vector>
+
+class CDupeModel;
+
+// Directories with the same contents, found from the results of a scan
+// Every directory gets a Merkle digest, the MD5 of the sorted names and digests of its files and subdirectories,
+// computed bottom up over the interned path tree, so two directories match when their whole subtrees do
+// Only the topmost of nested duplicates are reported
+// A directory whose files all have a copy in one other directory is reported as contained in it
+class CDuplicateDirs
+{
+public:
+    struct SGroup
+    {
+        std::vector< QString > fDirs;
+        int fNumFiles{ 0 };   // in each directory's subtree
+        qint64 fSize{ 0 };
+    };
+    struct SSubset
+    {
+        QString fDir;
+        QString fContainedIn;
+        int fNumFiles{ 0 };   // directly in the directory
+        qint64 fSize{ 0 };
+    };
+
+    CDuplicateDirs( const CDupeModel *model );
+
+    void find();
+    const std::vector< SGroup > &groups() const { return fGroups; }   // largest first
+    const std::vector< SSubset > &subsets() const { return fSubsets; }
+
+private:
+    struct SEntry
+    {
+        QString fName;
+        SDigest fDigest;
+        bool fIsDir{ false };
+    };
+    struct SDir
+    {
+        std::vector< SEntry > fEntries;
+        std::vector< size_t > fFileGroups;   // of the files directly in it, sorted, files with the same digest are in the same group
+        qint64 fFileBytes{ 0 };   // directly in it
+        bool fHasDigest{ false };
+        SDigest fDigest;
+        int fNumFiles{ 0 };   // in the subtree
+        qint64 fSize{ 0 };
+        bool fDuplicated{ false };
+    };
+
+    void hashDirs();
+    void groupDirs();
+    void findSubsets();
+
+    const CDupeModel *fModel{ nullptr };
+    std::vector< SDir > fDirs;   // by path store directory id
+    std::vector< SGroup > fGroups;
+    std::vector< SSubset > fSubsets;
+};
+
+#endif
@@ -1,33 +1,83 @@
 #include "FileFinder.h"
 #include "MainWindow.h"
-#include "SABUtils/MD5.h"
+#include "ScanSnapshot.h"
+#include "HashPipeline.h"
+#include "ChunkIndex.h"
+#include "ImageIndex.h"
+#include "NameMatcher.h"
 #include "SABUtils/utils.h"
 
+#include <QCryptographicHash>
+#include <QFile>
 #include <QThreadPool>
+#include <QtAlgorithms>
 #include <QDir>
 #include <QDirIterator>
 
 CFileFinder::CFileFinder( QObject * parent ) :
-    QObject( parent )
+    QObject( parent ),
+    fStopFlag( std::make_shared< std::atomic< bool > >( false ) ),
+    fHashRelay( new CHashRelay, []( CHashRelay * relay ) { relay->deleteLater(); } )   // the last reference may go on a hasher thread
 {
     setAutoDelete( false );
+    connect( fHashRelay.get(), &CHashRelay::sigMD5FileFinished, this, &CFileFinder::sigMD5FileFinished );
+    connect( fHashRelay.get(), &CHashRelay::sigFileChanged, this, &CFileFinder::sigFileChanged );
+}
+
+CFileFinder::~CFileFinder()
+{
+    fStopFlag->store( true );   // hash jobs still in flight skip their work, any that already finished report to the relay which is no longer connected
+}
+
+static QString joinPath( const QString & dirName, const QString & name )
+{
+    return dirName.endsWith( '/' ) ? ( dirName + name ) : ( dirName + "/" + name );
 }
 
 void CFileFinder::run()
 {
-    processDir( fRootDir );
+    if ( fDirsToRescan.isEmpty() )
+        processDir( fRootDir );
+    else
+    {
+        for ( auto && ii : fDirsToRescan )
+            processDir( ii, true );
+    }
+    flushSmallFiles();
 
     emit sigNumFilesFinished( fNumFilesFound );
     emit sigFinished();
 }
 
+void CFileFinder::setRootDir( const QString & rootDir )
+{
+    fRootDir = QDir::cleanPath( QDir( rootDir ).absolutePath() );
+}
+
+void CFileFinder::setDirsToRescan( const QStringList & dirs )
+{
+    fDirsToRescan = dirs;
+    fStopped = false;
+    fStopFlag = std::make_shared< std::atomic< bool > >( false );
+    fNumFilesFound = 0;
+}
+
 void CFileFinder::reset()
 {
+    fDirsToRescan.clear();
     fStopped = false;
     fIgnoreHidden = false;
     fRootDir.clear();
     fIgnoredPathNames.clear();
-    fMD5Threads.clear();
+    fFilter.clear();
+    fSnapshot.reset();
+    fProgress.reset();
+    fChunkIndex.reset();
+    fImageIndex.reset();
+    fNameMatcher.reset();
+    fSmallFilesUnder = 0;
+    fSmallFiles.clear();
+    fStopFlag = std::make_shared< std::atomic< bool > >( false );
     fNumFilesFound = 0;
 }
 
@@ -35,128 +85,288 @@ void CFileFinder::slotStop()
 {
     qDebug() << "File Finder Stopped";
     fStopped = true; 
-    CMainWindow::threadPool()->clear();
-    for ( auto && ii : fMD5Threads )
-    {
-        if ( !ii.second )
-            continue;
-        ii.second->stop();
-    }
-    fMD5Threads.clear();
+    fStopFlag->store( true );   // only this finder's jobs see the flag, other jobs on the shared pool are left alone
 
     emit sigStopped();
 }
 
-int CFileFinder::getPriority( const QString & fileName ) const
+int CFileFinder::getPriority( qint64 sz ) const
 {
-    QFileInfo fi( fileName );
+    // largest first (longest processing time first), so the scan does not end with one thread reading a huge file
+    // while the others are idle, the small files fill in the gaps; quarter powers of two are close enough to sorted
+    if ( sz <= 0 )
+        return 0;
+    auto bits = 64 - qCountLeadingZeroBits( static_cast< quint64 >( sz ) );
+    auto fraction = ( bits > 2 ) ? static_cast< int >( ( sz >> ( bits - 3 ) ) & 3 ) : 0;
+    return bits * 4 + fraction;
+}
 
-    auto sz = fi.size();
-    auto limit = 1000;
-    auto priority = 10;
-    while( priority > 1 )
+std::vector< SDirEntry > CFileFinder::getDirEntries( const QString & dirName, bool forceEnumerate )
+{
+    QFileInfo dirFI( dirName );
+    if ( !dirFI.exists() || !dirFI.isDir() )
+        return {};
+
+    auto dirMTime = dirFI.lastModified().toMSecsSinceEpoch();
+    if ( fSnapshot && !forceEnumerate )
     {
-        if ( sz < limit )
-            return priority;
-        limit *= 10;
-        priority--;
+        auto entries = fSnapshot->entries( dirName, dirMTime );
+        if ( entries.has_value() )
+        {
+            // the directory's mtime only covers files being added, removed or renamed, a file rewritten in place
+            // keeps it, so every file is stat'ed again or its recorded digest would be reused for new contents
+            auto prefix = dirName.endsWith( '/' ) ? dirName : ( dirName + "/" );
+            auto retVal = entries.value();
+            bool changed = false;
+            bool missing = false;
+            for ( auto && ii : retVal )
+            {
+                if ( ii.fIsDir )
+                    continue;
+                QFileInfo fi( prefix + ii.fName );
+                if ( !fi.exists() )
+                {
+                    missing = true;   // the recorded entries are stale, enumerate the directory
+                    break;
+                }
+                SDirEntry current( fi );
+                if ( ( current.fSize == ii.fSize ) && ( current.fMTime == ii.fMTime ) && ( current.fCTime == ii.fCTime ) )
+                    continue;
+                ii = current;
+                changed = true;
+            }
+            if ( !missing )
+            {
+                if ( changed )
+                    fSnapshot->setEntries( dirName, dirMTime, retVal );
+                return retVal;
+            }
+        }
+    }
 
+    std::vector< SDirEntry > retVal;
+    QDirIterator di( dirName, QStringList() << "*", QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot | QDir::Readable, QDirIterator::NoIteratorFlags );
+    while ( !fStopped && di.hasNext() )
+    {
+        di.next();
+        retVal.emplace_back( di.fileInfo() );   // uses the data from the directory enumeration where the platform provides it
     }
-    return priority;
+
+    if ( fSnapshot && !fStopped )
+    {
+        if ( !fDirsToRescan.isEmpty() )
+            reportRemoved( dirName, retVal );
+        fSnapshot->setEntries( dirName, dirMTime, retVal );
+    }
+    return retVal;
 }
 
-void CFileFinder::processDir( const QString& dirName )
+void CFileFinder::reportRemoved( const QString & dirName, const std::vector< SDirEntry > & entries )
 {
-    QDir dir( dirName );
-    if ( !dir.exists() )
+    auto previous = fSnapshot->previousEntries( dirName );
+    if ( !previous.has_value() )
         return;
 
-    QDirIterator di( dirName, QStringList() << "*", QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot | QDir::Readable, QDirIterator::NoIteratorFlags );
-    while ( !fStopped && di.hasNext() )
+    std::unordered_map< QString, const SDirEntry * > current;
+    for ( auto && ii : entries )
+        current[ ii.fName ] = &ii;
+
+    for ( auto && ii : previous.value() )
+    {
+        auto pos = current.find( ii.fName );
+        bool removed = ( pos == current.end() ) || ( ( *pos ).second->fIsDir != ii.fIsDir );
+        if ( ii.fIsDir )
+        {
+            if ( removed )
+            {
+                fSnapshot->removeDir( joinPath( dirName, ii.fName ) );
+                emit sigDirRemoved( joinPath( dirName, ii.fName ) );
+            }
+        }
+        else if ( removed || ( ( *pos ).second->fSize != ii.fSize ) || ( ( *pos ).second->fMTime != ii.fMTime ) )
+            emit sigFileRemoved( joinPath( dirName, ii.fName ) );
+    }
+}
+
+void CFileFinder::processDir( const QString& dirName, bool forceEnumerate )
+{
+    auto entries = getDirEntries( dirName, forceEnumerate );
+    for ( auto && entry : entries )
     {
-        auto curr = di.next();
+        if ( fStopped )
+            break;
 
-        QFileInfo fi( curr );
-        if ( isIgnoredPath( fi ) )
+        auto curr = joinPath( dirName, entry.fName );
+        if ( isIgnoredPath( curr, entry ) )
             continue;
 
-        if ( fi.isDir() )
+        if ( entry.fIsDir )
         {
+            if ( !fFilter.acceptsDir( curr ) )
+                continue;
+            if ( !fDirsToRescan.isEmpty() && fSnapshot && fSnapshot->hasDir( curr ) )
+                continue; // only new directories are walked when rescanning
             processDir( curr );
-            emit sigFilesFound( fNumFilesFound );
         }
         else
         {
-            if ( fIgnoreFilesOver.first && ( fi.size() >= static_cast< qint64 >( fIgnoreFilesOver.second )*1024LL*1024LL ) )
+            if ( fIgnoreFilesOver.first && ( entry.fSize >= static_cast< qint64 >( fIgnoreFilesOver.second )*1024LL*1024LL ) )
                  continue;
 
-            fNumFilesFound++;
+            if ( !fFilter.acceptsFile( curr, entry ) )
+                continue;
 
-            emit sigCurrentFindInfo( fi.absoluteFilePath() );
-            emit sigFilesFound( fNumFilesFound );
+            fNumFilesFound++;
+            if ( fProgress )
+                fProgress->fileFound( fStage, curr, entry.fSize );
 
-            processFile( curr );
+            processFile( curr, entry );
         }
     }
     emit sigDirFinished( dirName );
 }
 
-bool CFileFinder::isIgnoredPath( const QFileInfo & fi ) const
+bool CFileFinder::isIgnoredPath( const QString & path, const SDirEntry & entry ) const
 {
-    if ( fIgnoreHidden && ( fi.isHidden() || fi.fileName().startsWith( "." ) ) )
+    if ( fIgnoreHidden && ( entry.fIsHidden || entry.fName.startsWith( "." ) ) )
         return true;
 
-    bool isWC = false;
-    auto pathName = fi.fileName().toLower();
-    for ( auto && ii : fIgnoredPathNames )
-    {
-        auto match = ii.match( pathName );
-        if ( match.hasMatch() )
-            return true;
-    }
-    return false;
+    QString relPath;
+    if ( fIgnoredPathNames.needsRelativePath() )
+        relPath = QDir( fRootDir ).relativeFilePath( path );
+    return fIgnoredPathNames.isIgnored( entry.fName, relPath, entry.fIsDir );
 }
  
-void CFileFinder::processFile( const QString & fileName )
+void CFileFinder::processFile( const QString & fileName, const SDirEntry & entry )
 {
-    if ( fCaseInsensitiveNameCompare )
+    // empty files have never been reported as duplicates (every empty file would be one group, and the keep policy would
+    // mark all but one for deletion), they are dropped here before anything is opened or scheduled
+    if ( entry.fSize == 0 )
+    {
+        if ( fProgress )
+            fProgress->fileHashed();
+        return;
+    }
+
+    if ( fNameMatcher )
     {
-        auto fn = QFileInfo( fileName ).fileName().toLower();
-        emit sigMD5FileStarted( 0, QDateTime::currentDateTime(), fileName );
-        auto md5Results = NSABUtils::getMd5( fn, false );
-        emit sigMD5FileFinished( 0, QDateTime::currentDateTime(), fileName, md5Results );
+        if ( fProgress )
+            fProgress->fileHashed();
+        if ( fDirsToRescan.isEmpty() )
+            fNameMatcher->addFile( fileName, entry );
+        else
+            emit sigMD5FileFinished( 0, QDateTime::currentDateTime(), hashedFile( fileName, entry, fNameMatcher->digest( fileName, entry ) ) );
         return;
     }
 
-    auto md5 = new NSABUtils::CComputeMD5( fileName );
-    connect( md5, &NSABUtils::CComputeMD5::sigStarted, this, &CFileFinder::sigMD5FileStarted );
-    connect( md5, &NSABUtils::CComputeMD5::sigReadPositionStatus, this, &CFileFinder::sigMD5ReadPositionStatus );
-    connect( md5, &NSABUtils::CComputeMD5::sigFinishedReading, this, &CFileFinder::sigMD5FileFinishedReading );
-    connect( md5, &NSABUtils::CComputeMD5::sigFinishedComputing, this, &CFileFinder::sigMD5FileFinishedComputing );
-    connect( md5, &NSABUtils::CComputeMD5::sigFinished, this, &CFileFinder::sigMD5FileFinished );
-    connect( md5, &NSABUtils::CComputeMD5::sigFinished, this, &CFileFinder::slotMD5FileFinished );
-    connect( this, &CFileFinder::sigStopped, md5, &NSABUtils::CComputeMD5::slotStop );
+    if ( fImageIndex && CImageIndex::isImage( entry.fName ) )
+        fImageIndex->addImage( fileName, fStopFlag, getPriority( entry.fSize ) );
+
+    auto mode = EHashMode::eWholeFile;
+    if ( fHashLargeFilesOver.first && ( entry.fSize >= static_cast< qint64 >( fHashLargeFilesOver.second ) * 1024LL * 1024LL ) )
+        mode = fLargeFileMode;
+    auto smallFile = entry.fSize < fSmallFilesUnder;
+    if ( fSnapshot )
+    {
+        auto digest = fSnapshot->digest( fileName, entry, mode );
+        if ( digest.has_value() )
+        {
+            if ( fProgress )
+                fProgress->fileHashed();
+            if ( fChunkIndex && ( mode != EHashMode::eWholeFile ) )
+                fChunkIndex->addFile( fileName, entry.fSize, digest.value(), mode, fSnapshot->chunkDigests( fileName ) );
+            if ( smallFile )
+                addSmallFile( fileName, entry, digest.value() );
+            else
+                emit sigMD5FileFinished( 0, QDateTime::currentDateTime(), hashedFile( fileName, entry, digest.value() ) );
+            return;
+        }
+        fSnapshot->addPending( fileName, entry );
+    }
+
+    // a job, a reader and a hasher hop cost more than reading a small file, it is hashed right here
+    if ( smallFile )
+    {
+        if ( fProgress )
+            fProgress->fileHashed();
 
-    auto priority = getPriority( fileName );
-    CMainWindow::threadPool()->start( md5, priority );
-    fMD5Threads[ fileName ] = md5;
+        QFile file( fileName );
+        if ( !file.open( QFile::ReadOnly ) )
+            return;
+        auto data = file.readAll();
+        if ( data.size() != entry.fSize )
+        {
+            emit sigFileChanged( fileName );
+            return;
+        }
+        auto digest = SDigest::fromBytes( QCryptographicHash::hash( data, QCryptographicHash::Md5 ) );
+        if ( fSnapshot )
+            fSnapshot->setDigest( fileName, digest );
+        addSmallFile( fileName, entry, digest );
+        return;
+    }
+
+    std::shared_ptr< CScanProgress::SJob > job;
+    if ( fProgress )
+        job = fProgress->createJob( fileName, entry.fSize );
+
+    // called on a hasher thread, the relay signal is queued to the finder so it never touches a deleted one
+    auto stopFlag = fStopFlag;
+    auto relay = fHashRelay;
+    auto snapshot = fSnapshot;
+    auto chunkIndex = ( mode != EHashMode::eWholeFile ) ? fChunkIndex : std::shared_ptr< CChunkIndex >();
+    auto hashed = hashedFile( fileName, entry, SDigest() );
+    auto reader = CMainWindow::hashPipeline()->createReader( fileName, mode, fProgress, job, stopFlag,
+        [ relay, stopFlag, snapshot, chunkIndex, hashed, mode ]( unsigned long long threadID, const SDigest &digest, const QByteArray &chunks ) mutable
+        {
+            // a file still being written when it was found would otherwise keep the digest of its first part
+            QFileInfo fi( hashed.fMeta.fPath );
+            if ( ( fi.size() != hashed.fMeta.fSize ) || ( fi.lastModified().toMSecsSinceEpoch() != hashed.fMeta.fMTime ) )
+            {
+                if ( !stopFlag->load() )
+                    emit relay->sigFileChanged( hashed.fMeta.fPath );
+                return;
+            }
+
+            if ( snapshot )
+                snapshot->setDigest( hashed.fMeta.fPath, digest, mode, chunks );
+            if ( chunkIndex )
+                chunkIndex->addFile( hashed.fMeta.fPath, hashed.fMeta.fSize, digest, mode, chunks );
+            hashed.fDigest = digest;
+            if ( !stopFlag->load() )
+                emit relay->sigMD5FileFinished( threadID, QDateTime::currentDateTime(), hashed );
+        } );
+
+    auto priority = getPriority( entry.fSize );
+    CMainWindow::threadPool()->start( reader, priority );
+}
+
+SHashedFile CFileFinder::hashedFile( const QString & fileName, const SDirEntry & entry, const SDigest & digest )
+{
+    return { { fileName, entry.fSize, entry.fMTime, entry.fCTime }, digest };
 }
 
-void CFileFinder::slotMD5FileFinished( unsigned long long /*threadID*/, const QDateTime &/*dt*/, const QString &filename, const QString &/*md5*/ )
+void CFileFinder::addSmallFile( const QString & fileName, const SDirEntry & entry, const SDigest & digest )
 {
-    auto pos = fMD5Threads.find( filename );
-    if ( pos == fMD5Threads.end() )
+    fSmallFiles.push_back( hashedFile( fileName, entry, digest ) );
+    if ( fSmallFiles.size() >= 1024 )
+        flushSmallFiles();
+}
+
+void CFileFinder::flushSmallFiles()
+{
+    if ( fSmallFiles.empty() )
         return;
-    fMD5Threads.erase( pos );
+    emit sigSmallFilesFinished( fSmallFiles );
+    fSmallFiles.clear();
 }
 
 void CFileFinder::setIgnoredPathNames( const NSABUtils::TCaseInsensitiveHash & ignoredFileNames )
 {
-    fIgnoredPathNames.clear();
+    QStringList patterns;
     for ( auto && ii : ignoredFileNames )
-    {
-        fIgnoredPathNames.push_back( QRegularExpression( "^" + ii + "$", QRegularExpression::CaseInsensitiveOption ) );
-    }
+        patterns << ii;
+    fIgnoredPathNames.setPatterns( patterns );
 }
 
 void CFileFinder::setIgnoreFilesOver( bool ignored, int ignoreOverMB )
@@ -164,15 +374,23 @@ void CFileFinder::setIgnoreFilesOver( bool ignored, int ignoreOverMB )
     fIgnoreFilesOver = { ignored, ignoreOverMB };
 }
 
+void CFileFinder::setHashLargeFilesOver( bool enabled, int overMB, EHashMode mode )
+{
+    fHashLargeFilesOver = { enabled, overMB };
+    fLargeFileMode = mode;
+}
+
 
 CComputeNumFiles::CComputeNumFiles( QObject * parent ) :
     CFileFinder( parent )
 {
+    fStage = CScanProgress::EStage::eCounting;
 
 }
 
-void CComputeNumFiles::processFile( const QString & fileName )
+void CComputeNumFiles::processFile( const QString & fileName, const SDirEntry & entry )
 {
     (void)fileName;
+    (void)entry;
 }
 
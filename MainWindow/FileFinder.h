@@ -2,16 +2,45 @@
 #define FILEFINDER_H
 
 #include "SABUtils/QtUtils.h"
-#include <QRegularExpression>
+#include "IgnoreMatcher.h"
+#include "ScanFilter.h"
+#include "DirEntry.h"
+#include "ScanProgress.h"
+#include "HashPipeline.h"
+#include "KeepPolicy.h"
 #include <QRunnable>
 #include <QObject>
 #include <unordered_set>
 #include <QString>
 #include <QPointer>
-namespace NSABUtils
+#include <memory>
+#include <vector>
+
+class CScanSnapshot;
+class CChunkIndex;
+class CImageIndex;
+class CNameMatcher;
+
+// a hashed file with the metadata the walk found it with, so the receivers never stat it again
+// files hashed by the walk itself are reported in batches rather than one signal each
+struct SHashedFile
+{
+    SFileMeta fMeta;
+    SDigest fDigest;
+};
+using THashedFiles = std::vector< SHashedFile >;
+Q_DECLARE_METATYPE( SHashedFile )
+Q_DECLARE_METATYPE( THashedFiles )
+
+// the hash jobs report through this rather than the finder, they hold a reference to it so it outlives them
+// the finder forwards its signal, and Qt drops the connection when the finder is deleted first
+class CHashRelay : public QObject
 {
-    class CComputeMD5;
-}
+    Q_OBJECT;
+Q_SIGNALS:
+    void sigMD5FileFinished( unsigned long long threadID, const QDateTime& dt, const SHashedFile& file );
+    void sigFileChanged( const QString& fileName );
+};
 
 class QFileInfo;
 class CFileFinder : public QObject, public QRunnable
@@ -19,13 +48,22 @@ class CFileFinder : public QObject, public QRunnable
     Q_OBJECT;
 public:
     CFileFinder( QObject * parent );
-    virtual ~CFileFinder() override = default;
+    virtual ~CFileFinder() override;
 
-    void setRootDir( const QString& rootDir ) { fRootDir = rootDir;  }
+    void setRootDir( const QString& rootDir );
     void setIgnoredPathNames( const NSABUtils::TCaseInsensitiveHash & ignoredFileNames );
     void setIgnoreHidden( bool ignoreHidden ) { fIgnoreHidden = ignoreHidden;  }
     void setIgnoreFilesOver( bool ignore, int ignoreOverMB );
-    void setCaseInsensitiveNameCompare( bool caseInsensitiveNameCompare ) { fCaseInsensitiveNameCompare = caseInsensitiveNameCompare; }
+    void setHashLargeFilesOver( bool enabled, int overMB, EHashMode mode );
+    void setSmallFilesUnder( int underKB ) { fSmallFilesUnder = underKB * 1024LL; }   // read and hashed on the finder's thread, 0 for none
+    void setFilter( const CScanFilter & filter ) { fFilter = filter; }
+    void setSnapshot( std::shared_ptr< CScanSnapshot > snapshot ) { fSnapshot = snapshot; }
+    void setProgress( std::shared_ptr< CScanProgress > progress ) { fProgress = progress; }
+    void setChunkIndex( std::shared_ptr< CChunkIndex > chunkIndex ) { fChunkIndex = chunkIndex; }   // receives the chunks of the tree and content defined hashes
+    void setImageIndex( std::shared_ptr< CImageIndex > imageIndex ) { fImageIndex = imageIndex; }   // images are also perceptually hashed
+    void setNameMatcher( std::shared_ptr< CNameMatcher > nameMatcher ) { fNameMatcher = nameMatcher; }   // files are matched by name instead of hashed
+    // instead of walking the root, re-enumerate only these directories (and any new subdirectories) against the snapshot
+    void setDirsToRescan( const QStringList & dirs );
 
     void run() override;
 
@@ -33,40 +71,54 @@ public:
     void reset();
 public Q_SLOTS:
     void slotStop();
-    void slotMD5FileFinished( unsigned long long threadID, const QDateTime &dt, const QString &filename, const QString &md5 );
 
 Q_SIGNALS:
     void sigStopped();
     void sigFinished();
-    void sigCurrentFindInfo( const QString& fileName );
 
     void sigNumFilesFinished( int numFiles ); // when the thread is finished finding all files
-    void sigFilesFound( int numFileFound );
 
-    void sigMD5FileStarted( unsigned long long threadID, const QDateTime& dt, const QString& filename );
-    void sigMD5ReadPositionStatus( unsigned long long threadID, const QDateTime &dt, const QString &filename, qint64 pos );
-    void sigMD5FileFinishedReading( unsigned long long threadID, const QDateTime& dt, const QString& filename );
-    void sigMD5FileFinishedComputing( unsigned long long threadID, const QDateTime& dt, const QString& filename );
-    void sigMD5FileFinished( unsigned long long threadID, const QDateTime& dt, const QString& filename, const QString& md5 );
+    void sigMD5FileFinished( unsigned long long threadID, const QDateTime& dt, const SHashedFile& file );
+    void sigSmallFilesFinished( const THashedFiles& files );
     void sigDirFinished( const QString& dirName );
+    void sigFileRemoved( const QString& fileName ); // only when rescanning, the file was deleted or modified
+    void sigFileChanged( const QString& fileName ); // the file changed while it was hashed, its digest was dropped
+    void sigDirRemoved( const QString& dirName ); // only when rescanning
 
 protected:
 
-    int getPriority( const QString & fileName ) const;
-    virtual void processDir( const QString &dirName );
+    int getPriority( qint64 size ) const;
+    std::vector< SDirEntry > getDirEntries( const QString & dirName, bool forceEnumerate );
+    void reportRemoved( const QString & dirName, const std::vector< SDirEntry > & entries );
+    virtual void processDir( const QString &dirName, bool forceEnumerate = false );
 
-    bool isIgnoredPath( const QFileInfo & fi ) const;
+    bool isIgnoredPath( const QString & path, const SDirEntry & entry ) const;
 
-    virtual void processFile( const QString & fileName );
+    virtual void processFile( const QString & fileName, const SDirEntry & entry );
+    static SHashedFile hashedFile( const QString & fileName, const SDirEntry & entry, const SDigest & digest );
+    void addSmallFile( const QString & fileName, const SDirEntry & entry, const SDigest & digest );
+    void flushSmallFiles();
 
     bool fStopped{ false };
     bool fIgnoreHidden{ false };
     QString fRootDir;
-    std::list< QRegularExpression > fIgnoredPathNames;
+    CIgnoreMatcher fIgnoredPathNames;
     int fNumFilesFound{ 0 };
-    std::unordered_map< QString, QPointer< NSABUtils::CComputeMD5 > > fMD5Threads;
+    CHashPipeline::TStopFlag fStopFlag;   // shared with the hash jobs started by this finder
+    std::shared_ptr< CHashRelay > fHashRelay;   // shared with the hash jobs started by this finder
     std::pair< bool, int > fIgnoreFilesOver{ false, 0 };
-    bool fCaseInsensitiveNameCompare{ false };
+    std::pair< bool, int > fHashLargeFilesOver{ false, 0 };
+    EHashMode fLargeFileMode{ EHashMode::eTree };
+    qint64 fSmallFilesUnder{ 0 };
+    THashedFiles fSmallFiles;   // not yet reported
+    CScanFilter fFilter;
+    std::shared_ptr< CScanSnapshot > fSnapshot;
+    std::shared_ptr< CScanProgress > fProgress;   // found files and hash jobs are reported here instead of per file signals
+    std::shared_ptr< CChunkIndex > fChunkIndex;
+    std::shared_ptr< CImageIndex > fImageIndex;
+    CScanProgress::EStage fStage{ CScanProgress::EStage::eFinding };
+    std::shared_ptr< CNameMatcher > fNameMatcher;   // a full scan only records the files, a rescan reports each file's group
+    QStringList fDirsToRescan;
 };
 
 class CComputeNumFiles : public CFileFinder
@@ -74,7 +126,7 @@ class CComputeNumFiles : public CFileFinder
 public:
     CComputeNumFiles( QObject * parent );
 
-    virtual void processFile( const QString & fileName ) override;
+    virtual void processFile( const QString & fileName, const SDirEntry & entry ) override;
 };
 
 #endif 
@@ -0,0 +1,530 @@
+#include "HashPipeline.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QtEndian>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <limits>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr unsigned long sBufferWait = 100;   // msecs between checks of the stop flag while waiting for a buffer
+constexpr int sDigestSize = 16;
+static const QByteArray sTreePrefix( "FDTREE1" );   // keeps a tree digest from ever equaling the MD5 of a file
+static const QByteArray sContentDefinedPrefix( "FDCDC1" );
+
+// content defined chunks average 64KB, the cut points are where the gear hash of the last 64 bytes has the mask bits clear,
+// a harder mask below the average and an easier one above it keeps the sizes close to the average (normalized chunking)
+constexpr qint64 sMinChunk = 16 * 1024;
+constexpr qint64 sAvgChunk = 64 * 1024;
+constexpr qint64 sMaxChunk = 256 * 1024;
+
+static constexpr quint64 spreadMask( int bits )
+{
+    quint64 retVal = 0;
+    for ( int ii = 0; ii < bits; ++ii )
+        retVal |= quint64( 1 ) << ( 63 - ii * 3 );
+    return retVal;
+}
+constexpr quint64 sMaskSmall = spreadMask( 18 );
+constexpr quint64 sMaskLarge = spreadMask( 14 );
+
+static std::array< quint64, 256 > makeGear()
+{
+    // fixed pseudo random values, the chunk boundaries must never change between runs
+    std::array< quint64, 256 > retVal;
+    quint64 state = 0x46445343444331ULL;
+    for ( auto &&ii : retVal )
+    {
+        state += 0x9E3779B97F4A7C15ULL;   // splitmix64
+        auto value = state;
+        value = ( value ^ ( value >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+        value = ( value ^ ( value >> 27 ) ) * 0x94D049BB133111EBULL;
+        ii = value ^ ( value >> 31 );
+    }
+    return retVal;
+}
+static const std::array< quint64, 256 > sGear = makeGear();
+
+struct CHashPipeline::SFile
+{
+    QString fFileName;
+    std::shared_ptr< CScanProgress > fProgress;
+    std::shared_ptr< CScanProgress::SJob > fJob;
+    TStopFlag fStopFlag;
+    TFinished fFinished;
+    EHashMode fMode{ EHashMode::eWholeFile };
+    QCryptographicHash fHash{ QCryptographicHash::Md5 };   // only touched by the hasher owning the file
+
+    QByteArray fChunks;   // the chunk digests of a tree hash or the chunk records of a content defined hash, in file order
+    QCryptographicHash fChunkHash{ QCryptographicHash::Md5 };   // content defined, the chunk being cut
+    qint64 fChunkLength{ 0 };
+    quint64 fGear{ 0 };
+    int fNumChunks{ 0 };
+    int fPendingChunks{ 0 };
+    bool fFinishing{ false };
+
+    QMutex fMutex;
+    std::deque< std::pair< char *, qint64 > > fBuffers;
+    bool fHashing{ false };   // one hasher at a time owns the file, so its buffers are hashed in order
+    bool fReadDone{ false };
+    bool fReadOK{ true };
+
+    bool stopped() const { return fStopFlag && fStopFlag->load( std::memory_order_relaxed ); }
+};
+
+class CHashRunnable : public QRunnable
+{
+public:
+    CHashRunnable( std::function< void() > func ) :
+        fFunc( func )
+    {
+    }
+    void run() override { fFunc(); }
+
+private:
+    std::function< void() > fFunc;
+};
+
+// Finds the holes of a sparse file through SEEK_DATA/SEEK_HOLE
+// Only files with fewer blocks allocated than their size are probed, where the filesystem does not support it
+// every byte is treated as data
+class CHoleFinder
+{
+public:
+    CHoleFinder( QFile &file )
+    {
+#if defined( Q_OS_UNIX ) && defined( SEEK_DATA )
+        struct stat info;
+        fHandle = file.handle();
+        fSparse = ( fHandle >= 0 ) && ( ::fstat( fHandle, &info ) == 0 ) && ( ( static_cast< qint64 >( info.st_blocks ) * 512 ) < info.st_size );
+#else
+        Q_UNUSED( file );
+#endif
+    }
+
+    bool isSparse() const { return fSparse; }
+
+    // true when no byte of the range is stored
+    bool isHole( qint64 pos, qint64 length )
+    {
+#if defined( Q_OS_UNIX ) && defined( SEEK_DATA )
+        if ( fSparse && ( pos >= fDataEnd ) )
+        {
+            // probing moves the file offset, it is put back so the QFile reading the file is not confused
+            auto current = ::lseek( fHandle, 0, SEEK_CUR );
+            fDataStart = ::lseek( fHandle, pos, SEEK_DATA );
+            if ( fDataStart >= 0 )
+                fDataEnd = ::lseek( fHandle, fDataStart, SEEK_HOLE );
+            else if ( errno == ENXIO )
+                fDataStart = fDataEnd = std::numeric_limits< qint64 >::max();   // nothing but a hole after pos
+            if ( ( fDataStart < 0 ) || ( fDataEnd < 0 ) )
+                fSparse = false;
+            ::lseek( fHandle, current, SEEK_SET );
+        }
+        return fSparse && ( fDataStart >= ( pos + length ) );
+#else
+        Q_UNUSED( pos );
+        Q_UNUSED( length );
+        return false;
+#endif
+    }
+
+private:
+    int fHandle{ -1 };
+    bool fSparse{ false };
+    qint64 fDataStart{ -1 };   // the data extent found by the last probe
+    qint64 fDataEnd{ -1 };
+};
+
+class CReadFile : public QRunnable
+{
+public:
+    CReadFile( CHashPipeline *pipeline, std::shared_ptr< CHashPipeline::SFile > file ) :
+        fPipeline( pipeline ),
+        fFile( file )
+    {
+    }
+
+    ~CReadFile() override
+    {
+        if ( !fStarted )
+            fPipeline->abandon();
+    }
+
+    void run() override
+    {
+        if ( fFile->stopped() )
+            return;   // queued before the scan stopped, the file is never opened and the destructor abandons it
+        fStarted = true;
+        auto threadID = reinterpret_cast< unsigned long long >( QThread::currentThreadId() );
+        if ( fFile->fProgress && fFile->fJob )
+            fFile->fProgress->jobStarted( fFile->fJob, threadID );
+
+        auto aOK = read();
+        if ( fFile->fJob )
+            fFile->fJob->setState( CScanProgress::EJobState::eComputing, QDateTime::currentMSecsSinceEpoch() );
+        fPipeline->finishReading( fFile, aOK );
+    }
+
+private:
+    bool read()
+    {
+        QFile file( fFile->fFileName );
+        if ( !file.open( QFile::ReadOnly ) )
+            return false;
+
+        CHoleFinder holes( file );
+        auto size = file.size();
+        qint64 pos = 0;
+        while ( !fFile->stopped() )
+        {
+            if ( holes.isSparse() )
+            {
+                if ( pos >= size )
+                    return true;
+
+                // a buffer at a time so tree chunks stay aligned
+                auto length = std::min( fPipeline->bufferSize(), size - pos );
+                if ( holes.isHole( pos, length ) )
+                {
+                    pos += length;
+                    if ( fFile->fProgress && fFile->fJob )
+                        fFile->fProgress->jobRead( fFile->fJob, pos );
+                    fPipeline->pushZeros( fFile, length );
+                    continue;
+                }
+                if ( ( file.pos() != pos ) && !file.seek( pos ) )
+                    return false;
+            }
+
+            auto buffer = fPipeline->acquireBuffer( fFile->fStopFlag );
+            if ( !buffer )
+                return false;
+
+            auto numRead = file.read( buffer, fPipeline->bufferSize() );
+            if ( numRead <= 0 )
+            {
+                fPipeline->releaseBuffer( buffer );
+                return numRead == 0;
+            }
+
+            pos += numRead;
+            if ( fFile->fProgress && fFile->fJob )
+                fFile->fProgress->jobRead( fFile->fJob, pos );
+            fPipeline->push( fFile, buffer, numRead );
+        }
+        return false;
+    }
+
+    CHashPipeline *fPipeline{ nullptr };
+    std::shared_ptr< CHashPipeline::SFile > fFile;
+    bool fStarted{ false };
+};
+
+CHashPipeline::CHashPipeline( int numBuffers, qint64 bufferSize ) :
+    fBufferSize( bufferSize ),
+    fNumBuffers( numBuffers ),
+    fMemory( static_cast< size_t >( numBuffers * bufferSize ) ),
+    fZeros( static_cast< size_t >( bufferSize ), 0 )
+{
+    fZeroChunkDigest = QCryptographicHash::hash( QByteArray::fromRawData( fZeros.data(), static_cast< int >( bufferSize ) ), QCryptographicHash::Md5 );
+    fFreeBuffers.reserve( numBuffers );
+    for ( int ii = 0; ii < numBuffers; ++ii )
+        fFreeBuffers.push_back( fMemory.data() + ii * bufferSize );
+
+    fHashers.setMaxThreadCount( std::max( 1, QThread::idealThreadCount() ) );
+}
+
+CHashPipeline::~CHashPipeline()
+{
+    fHashers.waitForDone();
+}
+
+QRunnable *CHashPipeline::createReader( const QString &fileName, EHashMode mode, std::shared_ptr< CScanProgress > progress, std::shared_ptr< CScanProgress::SJob > job, TStopFlag stopFlag, TFinished finished )
+{
+    auto file = std::make_shared< SFile >();
+    file->fFileName = fileName;
+    file->fMode = mode;
+    file->fProgress = progress;
+    file->fJob = job;
+    file->fStopFlag = stopFlag;
+    file->fFinished = finished;
+
+    fActiveFiles.fetch_add( 1, std::memory_order_acq_rel );
+    return new CReadFile( this, file );
+}
+
+char *CHashPipeline::acquireBuffer( const TStopFlag &stopFlag )
+{
+    QMutexLocker locker( &fBufferMutex );
+    while ( fFreeBuffers.empty() )
+    {
+        if ( stopFlag && stopFlag->load( std::memory_order_relaxed ) )
+            return nullptr;
+        fBufferFreed.wait( &fBufferMutex, sBufferWait );
+    }
+    auto retVal = fFreeBuffers.back();
+    fFreeBuffers.pop_back();
+    return retVal;
+}
+
+void CHashPipeline::releaseBuffer( char *buffer )
+{
+    if ( buffer == fZeros.data() )
+        return;
+
+    QMutexLocker locker( &fBufferMutex );
+    fFreeBuffers.push_back( buffer );
+    fBufferFreed.wakeOne();
+}
+
+void CHashPipeline::push( const std::shared_ptr< SFile > &file, char *buffer, qint64 size )
+{
+    QMutexLocker locker( &file->fMutex );
+    if ( file->fMode == EHashMode::eTree )
+    {
+        auto chunk = file->fNumChunks++;
+        file->fPendingChunks++;
+        locker.unlock();
+        fHashers.start( new CHashRunnable( [ this, file, chunk, buffer, size ]() { hashChunk( file, chunk, buffer, size ); } ) );
+        return;
+    }
+
+    file->fBuffers.emplace_back( buffer, size );
+    if ( file->fHashing )
+        return;
+    file->fHashing = true;
+    locker.unlock();
+    schedule( file );
+}
+
+void CHashPipeline::pushZeros( const std::shared_ptr< SFile > &file, qint64 size )
+{
+    QMutexLocker locker( &file->fMutex );
+    if ( file->fMode == EHashMode::eTree )
+    {
+        auto chunk = file->fNumChunks++;
+        if ( size == fBufferSize )
+        {
+            setChunkDigest( *file, chunk, fZeroChunkDigest );
+            return;
+        }
+        file->fPendingChunks++;
+        locker.unlock();
+        fHashers.start( new CHashRunnable( [ this, file, chunk, size ]() { hashChunk( file, chunk, fZeros.data(), size ); } ) );
+        return;
+    }
+
+    // consecutive holes are one entry however long they are, the hasher feeds them through in buffer sized pieces
+    if ( !file->fBuffers.empty() && ( file->fBuffers.back().first == fZeros.data() ) )
+        file->fBuffers.back().second += size;
+    else
+        file->fBuffers.emplace_back( fZeros.data(), size );
+    if ( file->fHashing )
+        return;
+    file->fHashing = true;
+    locker.unlock();
+    schedule( file );
+}
+
+void CHashPipeline::finishReading( const std::shared_ptr< SFile > &file, bool aOK )
+{
+    QMutexLocker locker( &file->fMutex );
+    file->fReadDone = true;
+    file->fReadOK = aOK;
+    if ( file->fMode == EHashMode::eTree )
+    {
+        if ( ( file->fPendingChunks != 0 ) || file->fFinishing )
+            return;
+        file->fFinishing = true;
+        locker.unlock();
+        fHashers.start( new CHashRunnable( [ this, file ]() { finish( file ); } ) );
+        return;
+    }
+
+    if ( file->fHashing )
+        return;
+    file->fHashing = true;
+    locker.unlock();
+    schedule( file );
+}
+
+void CHashPipeline::abandon()
+{
+    fActiveFiles.fetch_sub( 1, std::memory_order_acq_rel );
+}
+
+void CHashPipeline::schedule( const std::shared_ptr< SFile > &file )
+{
+    fHashers.start( new CHashRunnable( [ this, file ]() { hash( file ); } ) );
+}
+
+void CHashPipeline::hash( const std::shared_ptr< SFile > &file )
+{
+    while ( true )
+    {
+        QMutexLocker locker( &file->fMutex );
+        if ( file->fBuffers.empty() )
+        {
+            if ( file->fReadDone )
+                break;
+            file->fHashing = false;   // the reader schedules the file again with its next buffer
+            return;
+        }
+        auto buffer = file->fBuffers.front();
+        file->fBuffers.pop_front();
+        locker.unlock();
+
+        if ( buffer.first == fZeros.data() )
+            hashZeros( *file, buffer.second );
+        else if ( !file->stopped() )
+        {
+            if ( file->fMode == EHashMode::eContentDefined )
+                hashContentDefined( *file, buffer.first, buffer.second );
+            else
+                file->fHash.addData( buffer.first, static_cast< int >( buffer.second ) );
+        }
+        releaseBuffer( buffer.first );
+    }
+
+    finish( file );
+}
+
+void CHashPipeline::hashChunk( const std::shared_ptr< SFile > &file, int chunk, char *buffer, qint64 size )
+{
+    QByteArray digest;
+    if ( !file->stopped() )
+        digest = QCryptographicHash::hash( QByteArray::fromRawData( buffer, static_cast< int >( size ) ), QCryptographicHash::Md5 );
+    releaseBuffer( buffer );
+
+    QMutexLocker locker( &file->fMutex );
+    if ( !digest.isEmpty() )
+        setChunkDigest( *file, chunk, digest );
+    if ( ( --file->fPendingChunks != 0 ) || !file->fReadDone || file->fFinishing )
+        return;
+    file->fFinishing = true;
+    locker.unlock();
+    finish( file );
+}
+
+void CHashPipeline::hashZeros( SFile &file, qint64 size )
+{
+    for ( qint64 pos = 0; ( pos < size ) && !file.stopped(); pos += fBufferSize )
+    {
+        auto length = std::min( fBufferSize, size - pos );
+        if ( file.fMode == EHashMode::eContentDefined )
+            hashContentDefined( file, fZeros.data(), length );
+        else
+            file.fHash.addData( fZeros.data(), static_cast< int >( length ) );
+    }
+}
+
+void CHashPipeline::setChunkDigest( SFile &file, int chunk, const QByteArray &digest )
+{
+    auto offset = chunk * sDigestSize;
+    if ( file.fChunks.size() < offset + sDigestSize )
+        file.fChunks.resize( offset + sDigestSize );
+    std::copy( digest.begin(), digest.end(), file.fChunks.begin() + offset );
+}
+
+void CHashPipeline::hashContentDefined( SFile &file, const char *buffer, qint64 size )
+{
+    qint64 start = 0;
+    qint64 pos = 0;
+    while ( pos < size )
+    {
+        // no cut point can fall in the first sMinChunk bytes of a chunk, they are only hashed
+        if ( file.fChunkLength < sMinChunk )
+        {
+            auto skip = std::min( sMinChunk - file.fChunkLength, size - pos );
+            pos += skip;
+            file.fChunkLength += skip;
+            continue;
+        }
+
+        bool cut = false;
+        for ( ; !cut && ( pos < size ); ++pos )
+        {
+            file.fGear = ( file.fGear << 1 ) + sGear[ static_cast< quint8 >( buffer[ pos ] ) ];
+            auto mask = ( file.fChunkLength < sAvgChunk ) ? sMaskSmall : sMaskLarge;
+            file.fChunkLength++;
+            cut = ( ( file.fGear & mask ) == 0 ) || ( file.fChunkLength >= sMaxChunk );
+        }
+        if ( cut )
+        {
+            file.fChunkHash.addData( buffer + start, static_cast< int >( pos - start ) );
+            start = pos;
+            endContentDefinedChunk( file );
+        }
+    }
+    file.fChunkHash.addData( buffer + start, static_cast< int >( size - start ) );
+}
+
+void CHashPipeline::endContentDefinedChunk( SFile &file )
+{
+    auto digest = file.fChunkHash.result();
+    file.fChunkHash.reset();
+
+    char record[ sChunkRecordSize ];
+    std::memcpy( record, digest.constData(), sizeof( quint64 ) );
+    qToLittleEndian( static_cast< quint32 >( file.fChunkLength ), record + sizeof( quint64 ) );
+    file.fChunks.append( record, sChunkRecordSize );
+
+    file.fChunkLength = 0;
+    file.fGear = 0;
+}
+
+quint64 CHashPipeline::chunkHash( const QByteArray &chunks, int chunk )
+{
+    quint64 retVal;
+    std::memcpy( &retVal, chunks.constData() + chunk * sChunkRecordSize, sizeof( retVal ) );
+    return retVal;
+}
+
+quint32 CHashPipeline::chunkLength( const QByteArray &chunks, int chunk )
+{
+    return qFromLittleEndian< quint32 >( chunks.constData() + chunk * sChunkRecordSize + sizeof( quint64 ) );
+}
+
+void CHashPipeline::finish( const std::shared_ptr< SFile > &file )
+{
+    if ( file->fReadOK && !file->stopped() )
+    {
+        if ( file->fMode == EHashMode::eTree )
+        {
+            file->fHash.addData( sTreePrefix );
+            auto chunkSize = QByteArray::number( fBufferSize );
+            file->fHash.addData( chunkSize );
+            file->fHash.addData( file->fChunks );
+        }
+        else if ( file->fMode == EHashMode::eContentDefined )
+        {
+            if ( file->fChunkLength )
+                endContentDefinedChunk( *file );
+            file->fHash.addData( sContentDefinedPrefix );
+            file->fHash.addData( QByteArray::number( sAvgChunk ) );
+            file->fHash.addData( file->fChunks );
+        }
+        auto digest = SDigest::fromBytes( file->fHash.result() );
+        if ( file->fProgress && file->fJob )
+            file->fProgress->jobFinished( file->fJob, digest );
+        if ( file->fFinished )
+            file->fFinished( reinterpret_cast< unsigned long long >( QThread::currentThreadId() ), digest, file->fChunks );
+    }
+    else if ( file->fProgress && file->fJob )
+        file->fProgress->jobFinished( file->fJob, {} );
+
+    fActiveFiles.fetch_sub( 1, std::memory_order_acq_rel );
+}
@@ -0,0 +1,83 @@
+#ifndef HASHPIPELINE_H
+#define HASHPIPELINE_H
+
+#include "ScanProgress.h"
+#include "Digest.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QRunnable;
+
+// Hashes files in two stages so the disks and the cores are busy at the same time
+// Readers run on CMainWindow::threadPool() and fill fixed size buffers taken from a preallocated pool,
+// the hashers run on their own pool and consume the buffers of a file in order, handing them back when done
+// Memory is bounded by the buffer pool, a reader waits for a free buffer when the hashers fall behind
+// Large files can be tree hashed, every buffer is a chunk hashed on its own by whichever hasher is free
+// and the digest is the MD5 of the chunk digests, which are handed back for partial matching
+// Or they can be split into content defined chunks (FastCDC), the cut points follow the content rather than the offset,
+// so files that share most of their data at different offsets share most of their chunks
+// The holes of sparse files are never read, the hashers are handed zeros for them instead, and a hole covering a whole
+// tree chunk takes the precomputed digest of a zero chunk without being hashed at all
+class CHashPipeline
+{
+public:
+    using TFinished = std::function< void( unsigned long long threadID, const SDigest &digest, const QByteArray &chunks ) >;   // called on a hasher thread, chunks holds the chunk records unless the whole file was hashed
+    using TStopFlag = std::shared_ptr< std::atomic< bool > >;
+
+    // the chunk records of a content defined hash, the first bytes of the chunk's MD5 and its length, little endian
+    static constexpr int sChunkRecordSize = 12;
+    static quint64 chunkHash( const QByteArray &chunks, int chunk );
+    static quint32 chunkLength( const QByteArray &chunks, int chunk );
+
+    CHashPipeline( int numBuffers, qint64 bufferSize );
+    ~CHashPipeline();
+
+    // the reader is run by the caller's pool, finished is not called when the file can not be read or the stop flag is set
+    QRunnable *createReader( const QString &fileName, EHashMode mode, std::shared_ptr< CScanProgress > progress, std::shared_ptr< CScanProgress::SJob > job, TStopFlag stopFlag, TFinished finished );
+    bool isIdle() const { return fActiveFiles.load( std::memory_order_acquire ) == 0; }
+
+    qint64 bufferSize() const { return fBufferSize; }   // the chunk size of a tree hash
+    int numBuffers() const { return fNumBuffers; }   // more readers than this only wait for a buffer
+
+private:
+    friend class CReadFile;
+    struct SFile;
+
+    char *acquireBuffer( const TStopFlag &stopFlag );   // nullptr once stopped
+    void releaseBuffer( char *buffer );
+
+    void push( const std::shared_ptr< SFile > &file, char *buffer, qint64 size );
+    void pushZeros( const std::shared_ptr< SFile > &file, qint64 size );   // a hole of the file
+    void finishReading( const std::shared_ptr< SFile > &file, bool aOK );
+    void abandon();   // the reader was dropped from its pool before it ran
+    void schedule( const std::shared_ptr< SFile > &file );
+    void hash( const std::shared_ptr< SFile > &file );
+    void hashChunk( const std::shared_ptr< SFile > &file, int chunk, char *buffer, qint64 size );
+    void hashZeros( SFile &file, qint64 size );
+    void setChunkDigest( SFile &file, int chunk, const QByteArray &digest );
+    void hashContentDefined( SFile &file, const char *buffer, qint64 size );
+    void endContentDefinedChunk( SFile &file );
+    void finish( const std::shared_ptr< SFile > &file );
+
+    qint64 fBufferSize{ 0 };
+    int fNumBuffers{ 0 };
+    std::vector< char > fMemory;
+    std::vector< char * > fFreeBuffers;
+    std::vector< char > fZeros;   // one buffer of zeros, never handed out for reading
+    QByteArray fZeroChunkDigest;
+    QMutex fBufferMutex;
+    QWaitCondition fBufferFreed;
+
+    QThreadPool fHashers;
+    std::atomic< int > fActiveFiles{ 0 };
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include "IconLoader.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QPixmap>
+#include <QStandardPaths>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <algorithm>
+#include <functional>
+
+constexpr int sMemoryCacheKB = 64 * 1024;
+constexpr qint64 sDiskCacheBytes = 512LL * 1024 * 1024;
+constexpr int sMaxQueued = 512;   // requests for rows that scrolled away long ago are dropped
+constexpr int sPruneEvery = 256;   // thumbnails written to disk
+
+class CLoadNextIcon : public QRunnable
+{
+public:
+    CLoadNextIcon( std::function< void() > func ) :
+        fFunc( func )
+    {
+    }
+    void run() override { fFunc(); }
+
+private:
+    std::function< void() > fFunc;
+};
+
+CIconLoader::CIconLoader( const QSize &size, QObject *parent ) :
+    QObject( parent ),
+    fSize( size ),
+    fIcons( sMemoryCacheKB )
+{
+    fCacheDir = QDir( QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) ).absoluteFilePath( "thumbnails" );
+    QDir().mkpath( fCacheDir );
+
+    fPool.setMaxThreadCount( std::max( 1, QThread::idealThreadCount() / 2 ) );
+    connect( this, &CIconLoader::sigImageLoaded, this, &CIconLoader::slotImageLoaded, Qt::QueuedConnection );
+}
+
+CIconLoader::~CIconLoader()
+{
+    {
+        QMutexLocker locker( &fMutex );
+        fQueue.clear();
+    }
+    fPool.clear();
+    fPool.waitForDone();
+}
+
+QString CIconLoader::key( const SFileMeta &meta )
+{
+    return QString( "%1|%2|%3" ).arg( meta.fPath ).arg( meta.fMTime ).arg( meta.fSize );
+}
+
+QString CIconLoader::diskCacheFile( const QString &key ) const
+{
+    auto hash = QCryptographicHash::hash( key.toUtf8(), QCryptographicHash::Md5 ).toHex();
+    return QDir( fCacheDir ).absoluteFilePath( QString::fromLatin1( hash ) + ".png" );
+}
+
+QIcon CIconLoader::icon( const SFileMeta &meta )
+{
+    auto iconKey = key( meta );
+    if ( auto cached = fIcons.object( iconKey ) )
+        return *cached;
+
+    if ( fPending.contains( iconKey ) )
+        return {};
+    fPending.insert( iconKey );
+
+    {
+        QMutexLocker locker( &fMutex );
+        fQueue.push_back( { iconKey, meta } );
+        while ( fQueue.size() > sMaxQueued )
+        {
+            fPending.remove( fQueue.front().fKey );
+            fQueue.pop_front();
+        }
+    }
+
+    fPool.start( new CLoadNextIcon( [ this ]() { loadNext(); } ) );
+    return {};
+}
+
+void CIconLoader::loadNext()
+{
+    SRequest request;
+    {
+        QMutexLocker locker( &fMutex );
+        if ( fQueue.empty() )
+            return;
+        request = fQueue.back();   // newest first, it is most likely still on screen
+        fQueue.pop_back();
+    }
+
+    auto image = loadImage( request );
+    emit sigImageLoaded( request.fKey, request.fMeta.fPath, image );
+}
+
+QImage CIconLoader::loadImage( const SRequest &request )
+{
+    auto cacheFile = diskCacheFile( request.fKey );
+    QImage retVal;
+    if ( retVal.load( cacheFile, "PNG" ) )
+    {
+        QFile( cacheFile ).setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime );   // least recently used is pruned first
+        return retVal;
+    }
+
+    QImageReader reader( request.fMeta.fPath );
+    reader.setAutoTransform( true );
+    if ( !reader.canRead() )
+        return {};
+
+    auto size = reader.size();
+    if ( size.isValid() && ( ( size.width() > fSize.width() ) || ( size.height() > fSize.height() ) ) )
+        reader.setScaledSize( size.scaled( fSize, Qt::KeepAspectRatio ) );   // formats that support it decode directly at the smaller size
+
+    if ( !reader.read( &retVal ) )
+        return {};
+    if ( ( retVal.width() > fSize.width() ) || ( retVal.height() > fSize.height() ) )
+        retVal = retVal.scaled( fSize, Qt::KeepAspectRatio, Qt::SmoothTransformation );
+
+    if ( retVal.save( cacheFile, "PNG" ) )
+    {
+        bool prune = false;
+        {
+            QMutexLocker locker( &fMutex );
+            prune = ( ++fWritesSincePrune >= sPruneEvery );
+            if ( prune )
+                fWritesSincePrune = 0;
+        }
+        if ( prune )
+            pruneDiskCache();
+    }
+    return retVal;
+}
+
+void CIconLoader::pruneDiskCache() const
+{
+    std::vector< std::pair< qint64, QFileInfo > > files;
+    qint64 totalSize = 0;
+    QDirIterator di( fCacheDir, QStringList() << "*.png", QDir::Files );
+    while ( di.hasNext() )
+    {
+        di.next();
+        auto fi = di.fileInfo();
+        totalSize += fi.size();
+        files.emplace_back( fi.lastModified().toMSecsSinceEpoch(), fi );
+    }
+    if ( totalSize <= sDiskCacheBytes )
+        return;
+
+    std::sort( files.begin(), files.end(), []( const std::pair< qint64, QFileInfo > &lhs, const std::pair< qint64, QFileInfo > &rhs ) { return lhs.first < rhs.first; } );
+    for ( auto &&ii : files )
+    {
+        if ( totalSize <= sDiskCacheBytes * 3 / 4 )
+            break;
+        if ( QFile::remove( ii.second.absoluteFilePath() ) )
+            totalSize -= ii.second.size();
+    }
+}
+
+void CIconLoader::slotImageLoaded( const QString &key, const QString &fileName, const QImage &image )
+{
+    fPending.remove( key );
+
+    auto icon = new QIcon;
+    auto cost = 1;
+    if ( !image.isNull() )
+    {
+        *icon = QIcon( QPixmap::fromImage( image ) );
+        cost = std::max( 1, static_cast< int >( image.sizeInBytes() / 1024 ) );
+    }
+    fIcons.insert( key, icon, cost );   // files that are not images are cached too, so they are not read again
+
+    if ( !image.isNull() )
+        emit sigIconReady( fileName );
+}
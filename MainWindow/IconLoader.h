@@ -0,0 +1,61 @@
+#ifndef ICONLOADER_H
+#define ICONLOADER_H
+
+#include "KeepPolicy.h"
+
+#include <QCache>
+#include <QIcon>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QSize>
+#include <QThreadPool>
+#include <deque>
+
+// Thumbnails for the results view
+// icon() returns immediately, a thumbnail that is not cached yet is decoded at the thumbnail size on a background pool
+// and sigIconReady is emitted when it can be shown
+// Thumbnails are kept in an in-memory LRU and in an on-disk cache keyed by (path, mtime, size) so they survive restarts
+class CIconLoader : public QObject
+{
+    Q_OBJECT
+public:
+    CIconLoader( const QSize &size, QObject *parent );
+    ~CIconLoader() override;
+
+    QIcon icon( const SFileMeta &meta );   // a null icon until the thumbnail is ready, or when the file is not an image
+
+Q_SIGNALS:
+    void sigIconReady( const QString &fileName );
+    void sigImageLoaded( const QString &key, const QString &fileName, const QImage &image );   // from the workers
+
+private Q_SLOTS:
+    void slotImageLoaded( const QString &key, const QString &fileName, const QImage &image );
+
+private:
+    struct SRequest
+    {
+        QString fKey;
+        SFileMeta fMeta;
+    };
+
+    static QString key( const SFileMeta &meta );
+    QString diskCacheFile( const QString &key ) const;
+    void loadNext();
+    QImage loadImage( const SRequest &request );
+    void pruneDiskCache() const;
+
+    QSize fSize;
+    QString fCacheDir;
+    QCache< QString, QIcon > fIcons;
+    QSet< QString > fPending;
+
+    QMutex fMutex;   // guards the queue and the write count, shared with the workers
+    std::deque< SRequest > fQueue;
+    int fWritesSincePrune{ 0 };
+
+    QThreadPool fPool;
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "IgnoreMatcher.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <optional>
+
+// returns the unescaped literal if the regular expression has no meta characters
+static std::optional< QString > literalOf( const QString &regExp )
+{
+    static const QString sMetaChars = R"(\^$.|?*+()[]{})";
+
+    QString retVal;
+    retVal.reserve( regExp.length() );
+    for ( int ii = 0; ii < regExp.length(); ++ii )
+    {
+        auto ch = regExp[ ii ];
+        if ( ch == '\\' )
+        {
+            if ( ( ii + 1 ) >= regExp.length() )
+                return {};
+            auto next = regExp[ ++ii ];
+            if ( next.isLetterOrNumber() )   // \d \w \1 etc
+                return {};
+            retVal += next;
+        }
+        else if ( sMetaChars.contains( ch ) )
+            return {};
+        else
+            retVal += ch;
+    }
+    return retVal.toLower();
+}
+
+static void addLength( std::vector< int > &lengths, int length )
+{
+    if ( std::find( lengths.begin(), lengths.end(), length ) == lengths.end() )
+        lengths.push_back( length );
+}
+
+void CIgnoreMatcher::SPatternSet::add( const QString &pattern )
+{
+    if ( !QRegularExpression( pattern ).isValid() )
+    {
+        qWarning() << "Invalid ignore pattern" << pattern;
+        return;
+    }
+
+    if ( auto literal = literalOf( pattern ); literal.has_value() )
+    {
+        fLiterals.insert( literal.value() );
+        return;
+    }
+    if ( pattern.endsWith( ".*" ) )
+    {
+        if ( auto prefix = literalOf( pattern.left( pattern.length() - 2 ) ); prefix.has_value() && !prefix.value().isEmpty() )
+        {
+            fPrefixes.insert( prefix.value() );
+            addLength( fPrefixLengths, prefix.value().length() );
+            return;
+        }
+    }
+    if ( pattern.startsWith( ".*" ) )
+    {
+        if ( auto suffix = literalOf( pattern.mid( 2 ) ); suffix.has_value() && !suffix.value().isEmpty() )
+        {
+            fSuffixes.insert( suffix.value() );
+            addLength( fSuffixLengths, suffix.value().length() );
+            return;
+        }
+    }
+    fRegExps << "(?:" + pattern + ")";
+}
+
+void CIgnoreMatcher::SPatternSet::compile()
+{
+    if ( fRegExps.isEmpty() )
+    {
+        fCombined = QRegularExpression();
+        return;
+    }
+
+    fCombined = QRegularExpression( "^(?:" + fRegExps.join( "|" ) + ")$", QRegularExpression::CaseInsensitiveOption );
+    fCombined.optimize();   // compiles (and JITs) up front rather than on the first match from the finder thread
+}
+
+void CIgnoreMatcher::SPatternSet::clear()
+{
+    fLiterals.clear();
+    fPrefixes.clear();
+    fPrefixLengths.clear();
+    fSuffixes.clear();
+    fSuffixLengths.clear();
+    fRegExps.clear();
+    fCombined = QRegularExpression();
+}
+
+bool CIgnoreMatcher::SPatternSet::matches( const QString &lowerText ) const
+{
+    if ( fLiterals.find( lowerText ) != fLiterals.end() )
+        return true;
+
+    for ( auto &&length : fPrefixLengths )
+    {
+        if ( ( length <= lowerText.length() ) && ( fPrefixes.find( lowerText.left( length ) ) != fPrefixes.end() ) )
+            return true;
+    }
+
+    for ( auto &&length : fSuffixLengths )
+    {
+        if ( ( length <= lowerText.length() ) && ( fSuffixes.find( lowerText.right( length ) ) != fSuffixes.end() ) )
+            return true;
+    }
+
+    if ( fRegExps.isEmpty() )
+        return false;
+    return fCombined.match( lowerText ).hasMatch();
+}
+
+void CIgnoreMatcher::setPatterns( const QStringList &patterns )
+{
+    clear();
+    for ( auto &&ii : patterns )
+    {
+        if ( ii.isEmpty() )
+            continue;
+
+        if ( ii.endsWith( '/' ) )
+        {
+            auto dirPattern = ii.left( ii.length() - 1 );
+            if ( dirPattern.contains( '/' ) )
+                fPaths.add( dirPattern );
+            else
+                fDirNames.add( dirPattern );
+        }
+        else if ( ii.contains( '/' ) )
+            fPaths.add( ii );
+        else
+            fNames.add( ii );
+    }
+    fNames.compile();
+    fDirNames.compile();
+    fPaths.compile();
+}
+
+void CIgnoreMatcher::clear()
+{
+    fNames.clear();
+    fDirNames.clear();
+    fPaths.clear();
+}
+
+bool CIgnoreMatcher::isIgnored( const QString &name, const QString &relPath, bool isDir ) const
+{
+    if ( isEmpty() )
+        return false;
+
+    auto lowerName = name.toLower();
+    if ( fNames.matches( lowerName ) )
+        return true;
+    if ( isDir && fDirNames.matches( lowerName ) )
+        return true;
+    if ( !fPaths.isEmpty() && fPaths.matches( relPath.toLower() ) )
+        return true;
+    return false;
+}
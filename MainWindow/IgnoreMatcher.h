@@ -0,0 +1,51 @@
+#ifndef IGNOREMATCHER_H
+#define IGNOREMATCHER_H
+
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <unordered_set>
+#include <vector>
+
+// All ignore patterns compiled into a single matcher, so the cost per entry does not depend on the number of patterns
+// Patterns are case insensitive regular expressions anchored at both ends
+//    name              - matched against the file or directory name
+//    name/             - matched against directory names only, the directory is never entered
+//    some/path         - any pattern containing a '/' is matched against the path relative to the root directory
+// Plain literals, "literal.*" and ".*literal" patterns are handled via hash lookups, the rest by one combined regular expression
+class CIgnoreMatcher
+{
+public:
+    void setPatterns( const QStringList &patterns );
+    void clear();
+
+    bool isEmpty() const { return fNames.isEmpty() && fDirNames.isEmpty() && fPaths.isEmpty(); }
+    bool needsRelativePath() const { return !fPaths.isEmpty(); }
+
+    // relPath is only used when needsRelativePath() is true
+    bool isIgnored( const QString &name, const QString &relPath, bool isDir ) const;
+
+private:
+    struct SPatternSet
+    {
+        void add( const QString &pattern );
+        void compile();
+        void clear();
+        bool isEmpty() const { return fLiterals.empty() && fPrefixes.empty() && fSuffixes.empty() && fRegExps.isEmpty(); }
+        bool matches( const QString &lowerText ) const;
+
+        std::unordered_set< QString > fLiterals;
+        std::unordered_set< QString > fPrefixes;
+        std::vector< int > fPrefixLengths;
+        std::unordered_set< QString > fSuffixes;
+        std::vector< int > fSuffixLengths;
+        QStringList fRegExps;
+        QRegularExpression fCombined;
+    };
+
+    SPatternSet fNames;
+    SPatternSet fDirNames;
+    SPatternSet fPaths;
+};
+
+#endif
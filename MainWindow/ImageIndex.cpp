@@ -0,0 +1,222 @@
+#include "ImageIndex.h"
+
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSet>
+#include <QThread>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+
+constexpr int sDecodeSize = 64;   // decoded at about this size before being reduced, so the reduction averages over an area
+constexpr size_t sMaxBucket = 1024;   // hashes compared pair by pair, a larger bucket is split again by the bits it does not share
+
+class CHashImage : public QRunnable
+{
+public:
+    CHashImage( std::function< void() > func ) :
+        fFunc( func )
+    {
+    }
+    void run() override { fFunc(); }
+
+private:
+    std::function< void() > fFunc;
+};
+
+CImageIndex::CImageIndex()
+{
+    fPool.setMaxThreadCount( std::max( 1, QThread::idealThreadCount() ) );
+}
+
+CImageIndex::~CImageIndex()
+{
+    fPool.clear();
+    fPool.waitForDone();
+}
+
+bool CImageIndex::isImage( const QString &fileName )
+{
+    static const QSet< QString > suffixes = []()
+    {
+        QSet< QString > retVal;
+        for ( auto &&ii : QImageReader::supportedImageFormats() )
+            retVal.insert( QString::fromLatin1( ii ).toLower() );
+        return retVal;
+    }();
+    return suffixes.contains( QFileInfo( fileName ).suffix().toLower() );
+}
+
+std::optional< quint64 > CImageIndex::differenceHash( const QString &fileName )
+{
+    QImageReader reader( fileName );
+    reader.setAutoTransform( true );
+    if ( !reader.canRead() )
+        return {};
+
+    auto size = reader.size();
+    if ( size.isValid() && ( ( size.width() > sDecodeSize ) || ( size.height() > sDecodeSize ) ) )
+        reader.setScaledSize( QSize( sDecodeSize, sDecodeSize ) );   // formats that support it decode directly at the smaller size
+
+    QImage image;
+    if ( !reader.read( &image ) )
+        return {};
+    image = image.convertToFormat( QImage::Format_Grayscale8 ).scaled( 9, 8, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+
+    quint64 retVal = 0;
+    for ( int yy = 0; yy < 8; ++yy )
+    {
+        auto line = image.constScanLine( yy );
+        for ( int xx = 0; xx < 8; ++xx )
+            retVal = ( retVal << 1 ) | ( ( line[ xx ] < line[ xx + 1 ] ) ? 1 : 0 );
+    }
+    return retVal;
+}
+
+void CImageIndex::addImage( const QString &fileName, CHashPipeline::TStopFlag stopFlag, int priority )
+{
+    fPending.fetch_add( 1, std::memory_order_acq_rel );
+    fPool.start( new CHashImage( [ this, fileName, stopFlag ]() { hashImage( fileName, stopFlag ); } ), priority );
+}
+
+void CImageIndex::hashImage( const QString &fileName, const CHashPipeline::TStopFlag &stopFlag )
+{
+    if ( !stopFlag || !stopFlag->load( std::memory_order_relaxed ) )
+    {
+        auto hash = differenceHash( fileName );
+        if ( hash.has_value() )
+        {
+            QMutexLocker locker( &fMutex );
+            fFileNames.push_back( fileName );
+            fHashes.push_back( hash.value() );
+        }
+    }
+    fPending.fetch_sub( 1, std::memory_order_acq_rel );
+}
+
+int CImageIndex::numImages() const
+{
+    QMutexLocker locker( &fMutex );
+    return static_cast< int >( fHashes.size() );
+}
+
+static quint32 findRoot( std::vector< quint32 > &parents, quint32 id )
+{
+    while ( parents[ id ] != id )
+    {
+        parents[ id ] = parents[ parents[ id ] ];
+        id = parents[ id ];
+    }
+    return id;
+}
+
+static void unite( std::vector< quint32 > &parents, quint32 lhs, quint32 rhs )
+{
+    lhs = findRoot( parents, lhs );
+    rhs = findRoot( parents, rhs );
+    if ( lhs != rhs )
+        parents[ std::max( lhs, rhs ) ] = std::min( lhs, rhs );
+}
+
+// Joins the hashes within maxDistance of each other, all of them agree on the used bits
+// A bucket too large to compare pair by pair is split by the remaining bits into maxDistance + 1 blocks,
+// a pair within the distance still agrees on a whole block so no pair is lost however the hashes cluster
+static void joinSimilar( const std::vector< quint64 > &hashes, const std::vector< quint32 > &ids, quint64 usedBits, int maxDistance, std::vector< quint32 > &parents )
+{
+    if ( ids.size() < 2 )
+        return;
+
+    std::vector< int > freeBits;
+    for ( int ii = 0; ii < 64; ++ii )
+    {
+        if ( ( usedBits & ( quint64( 1 ) << ii ) ) == 0 )
+            freeBits.push_back( ii );
+    }
+    auto numBlocks = maxDistance + 1;
+    auto numFree = static_cast< int >( freeBits.size() );
+    if ( ( ids.size() <= sMaxBucket ) || ( numFree < numBlocks ) )
+    {
+        // small enough, or too few bits left to split on, the hashes differ in at most numFree bits so there are at most 2^numFree of them
+        for ( size_t ii = 0; ii < ids.size(); ++ii )
+        {
+            for ( auto jj = ii + 1; jj < ids.size(); ++jj )
+            {
+                if ( qPopulationCount( hashes[ ids[ ii ] ] ^ hashes[ ids[ jj ] ] ) <= static_cast< uint >( maxDistance ) )
+                    unite( parents, ids[ ii ], ids[ jj ] );
+            }
+        }
+        return;
+    }
+
+    std::vector< std::pair< quint64, quint32 > > keys;
+    keys.reserve( ids.size() );
+    std::vector< quint32 > bucket;
+    for ( int block = 0; block < numBlocks; ++block )
+    {
+        quint64 mask = 0;
+        for ( auto ii = block * numFree / numBlocks; ii < ( block + 1 ) * numFree / numBlocks; ++ii )
+            mask |= quint64( 1 ) << freeBits[ ii ];
+
+        keys.clear();
+        for ( auto &&ii : ids )
+            keys.emplace_back( hashes[ ii ] & mask, ii );
+        std::sort( keys.begin(), keys.end() );
+
+        for ( size_t begin = 0, end = 0; begin < keys.size(); begin = end )
+        {
+            for ( end = begin + 1; ( end < keys.size() ) && ( keys[ end ].first == keys[ begin ].first ); ++end )
+                ;
+            if ( end - begin < 2 )
+                continue;
+            bucket.clear();
+            for ( auto ii = begin; ii < end; ++ii )
+                bucket.push_back( keys[ ii ].second );
+            joinSimilar( hashes, bucket, usedBits | mask, maxDistance, parents );
+        }
+    }
+}
+
+std::vector< CImageIndex::TGroup > CImageIndex::similarImages( int maxDistance ) const
+{
+    QMutexLocker locker( &fMutex );
+    auto numImages = static_cast< quint32 >( fHashes.size() );
+    std::vector< quint32 > parents( numImages );
+    std::iota( parents.begin(), parents.end(), 0 );
+
+    // identical hashes are joined first, so the buckets below only hold distinct hashes
+    std::vector< quint32 > order( numImages );
+    std::iota( order.begin(), order.end(), 0 );
+    std::sort( order.begin(), order.end(), [ this ]( quint32 lhs, quint32 rhs ) { return fHashes[ lhs ] < fHashes[ rhs ]; } );
+    std::vector< quint32 > distinct;
+    for ( auto &&ii : order )
+    {
+        if ( !distinct.empty() && ( fHashes[ ii ] == fHashes[ distinct.back() ] ) )
+            unite( parents, distinct.back(), ii );
+        else
+            distinct.push_back( ii );
+    }
+
+    joinSimilar( fHashes, distinct, 0, std::min( std::max( maxDistance, 0 ), 63 ), parents );
+
+    // the root of every set is its lowest id, so the first image of a group is the first one found
+    std::vector< TGroup > retVal;
+    std::vector< size_t > groupOfRoot( numImages, ~size_t( 0 ) );
+    for ( quint32 ii = 0; ii < numImages; ++ii )
+    {
+        auto root = findRoot( parents, ii );
+        if ( root == ii )
+            continue;
+        if ( groupOfRoot[ root ] == ~size_t( 0 ) )
+        {
+            groupOfRoot[ root ] = retVal.size();
+            retVal.push_back( { { fFileNames[ root ], 0 } } );
+        }
+        retVal[ groupOfRoot[ root ] ].push_back( { fFileNames[ ii ], static_cast< int >( qPopulationCount( fHashes[ root ] ^ fHashes[ ii ] ) ) } );
+    }
+    std::stable_sort( retVal.begin(), retVal.end(), []( const TGroup &lhs, const TGroup &rhs ) { return lhs.size() > rhs.size(); } );
+    return retVal;
+}
@@ -0,0 +1,53 @@
+#ifndef IMAGEINDEX_H
+#define IMAGEINDEX_H
+
+#include "HashPipeline.h"
+
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <optional>
+#include <vector>
+
+// Perceptual (difference) hashes of the scanned images, for finding resized and recompressed copies
+// Every image is decoded at a thumbnail size on the index's own pool and reduced to 64 bits, one per pair of
+// horizontally adjacent pixels of a 9x8 gray image, set when the left one is darker
+// Images within a Hamming distance are grouped through multi-index hashing, the hashes are split into distance + 1 blocks
+// and only hashes that agree on a whole block are compared, any two within the distance do on at least one
+// A block value shared by too many hashes is split the same way by the remaining bits, so crowded buckets lose no pairs
+class CImageIndex
+{
+public:
+    struct SImage
+    {
+        QString fFileName;
+        int fDistance{ 0 };   // to the first image of the group
+    };
+    using TGroup = std::vector< SImage >;
+
+    CImageIndex();
+    ~CImageIndex();
+
+    static bool isImage( const QString &fileName );   // by the suffix, formats Qt can decode
+    static std::optional< quint64 > differenceHash( const QString &fileName );
+
+    void addImage( const QString &fileName, CHashPipeline::TStopFlag stopFlag, int priority );   // hashed on the index's pool
+    bool isIdle() const { return fPending.load( std::memory_order_acquire ) == 0; }
+    int numImages() const;
+
+    // groups of two or more images, largest first
+    std::vector< TGroup > similarImages( int maxDistance ) const;
+
+private:
+    void hashImage( const QString &fileName, const CHashPipeline::TStopFlag &stopFlag );
+
+    mutable QMutex fMutex;
+    std::vector< QString > fFileNames;
+    std::vector< quint64 > fHashes;
+
+    QThreadPool fPool;
+    std::atomic< int > fPending{ 0 };
+};
+
+#endif
@@ -0,0 +1,200 @@
+#include "JobStatusModel.h"
+
+#include "SABUtils/utils.h"
+#include "SABUtils/FileUtils.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <algorithm>
+#include <unordered_set>
+
+CJobStatusModel::CJobStatusModel( QObject *parent ) :
+    QAbstractTableModel( parent )
+{
+}
+
+qint64 CJobStatusModel::sortKey( const CScanProgress::SJob &job, ESortBy sortBy ) const
+{
+    switch ( sortBy )
+    {
+        case ESortBy::eThreadID:
+            return static_cast< qint64 >( job.fThreadID.load( std::memory_order_relaxed ) );
+        case ESortBy::ePercentComplete:
+            return static_cast< qint64 >( job.percentage() * 1000 );
+        default:
+            return job.fSize;
+    }
+}
+
+void CJobStatusModel::update( const std::vector< std::shared_ptr< const CScanProgress::SJob > > &jobs, ESortBy sortBy )
+{
+    fNow = QDateTime::currentMSecsSinceEpoch();
+
+    // drop the rows whose job expired, a contiguous run at a time
+    std::unordered_set< const CScanProgress::SJob * > current;
+    current.reserve( jobs.size() );
+    for ( auto &&ii : jobs )
+        current.insert( ii.get() );
+
+    for ( int row = static_cast< int >( fJobs.size() ) - 1; row >= 0; )
+    {
+        if ( current.find( fJobs[ row ].get() ) != current.end() )
+        {
+            --row;
+            continue;
+        }
+        int last = row;
+        while ( ( row >= 0 ) && ( current.find( fJobs[ row ].get() ) == current.end() ) )
+            --row;
+        beginRemoveRows( QModelIndex(), row + 1, last );
+        fJobs.erase( fJobs.begin() + row + 1, fJobs.begin() + last + 1 );
+        endRemoveRows();
+    }
+
+    // append the jobs started since the last update
+    std::unordered_set< const CScanProgress::SJob * > known;
+    known.reserve( fJobs.size() );
+    for ( auto &&ii : fJobs )
+        known.insert( ii.get() );
+
+    std::vector< std::shared_ptr< const CScanProgress::SJob > > added;
+    for ( auto &&ii : jobs )
+    {
+        if ( known.find( ii.get() ) == known.end() )
+            added.push_back( ii );
+    }
+    if ( !added.empty() )
+    {
+        auto first = static_cast< int >( fJobs.size() );
+        beginInsertRows( QModelIndex(), first, first + static_cast< int >( added.size() ) - 1 );
+        fJobs.insert( fJobs.end(), added.begin(), added.end() );
+        endInsertRows();
+    }
+
+    if ( fJobs.empty() )
+        return;
+
+    // largest key first, only a changed order is reported as a layout change
+    std::vector< std::pair< qint64, int > > keys;
+    keys.reserve( fJobs.size() );
+    for ( int ii = 0; ii < static_cast< int >( fJobs.size() ); ++ii )
+        keys.emplace_back( sortKey( *fJobs[ ii ], sortBy ), ii );
+    std::stable_sort( keys.begin(), keys.end(), []( const std::pair< qint64, int > &lhs, const std::pair< qint64, int > &rhs ) { return lhs.first > rhs.first; } );
+
+    bool reordered = false;
+    for ( int ii = 0; !reordered && ( ii < static_cast< int >( keys.size() ) ); ++ii )
+        reordered = keys[ ii ].second != ii;
+
+    if ( reordered )
+    {
+        emit layoutAboutToBeChanged();
+        std::vector< int > newRow( fJobs.size() );
+        std::vector< std::shared_ptr< const CScanProgress::SJob > > sorted;
+        sorted.reserve( fJobs.size() );
+        for ( int ii = 0; ii < static_cast< int >( keys.size() ); ++ii )
+        {
+            newRow[ keys[ ii ].second ] = ii;
+            sorted.push_back( fJobs[ keys[ ii ].second ] );
+        }
+        fJobs.swap( sorted );
+
+        auto oldIndexes = persistentIndexList();
+        QModelIndexList newIndexes;
+        newIndexes.reserve( oldIndexes.size() );
+        for ( auto &&ii : oldIndexes )
+            newIndexes << index( newRow[ ii.row() ], ii.column() );
+        changePersistentIndexList( oldIndexes, newIndexes );
+        emit layoutChanged();
+    }
+
+    // the text is formatted by data(), so only the rows the view shows pay for it
+    emit dataChanged( index( 0, eState ), index( static_cast< int >( fJobs.size() ) - 1, eNumColumns - 1 ), { Qt::DisplayRole } );
+}
+
+int CJobStatusModel::rowCount( const QModelIndex &parent ) const
+{
+    if ( parent.isValid() )
+        return 0;
+    return static_cast< int >( fJobs.size() );
+}
+
+int CJobStatusModel::columnCount( const QModelIndex &parent ) const
+{
+    if ( parent.isValid() )
+        return 0;
+    return eNumColumns;
+}
+
+QVariant CJobStatusModel::data( const QModelIndex &index, int role ) const
+{
+    if ( !index.isValid() || ( index.row() >= static_cast< int >( fJobs.size() ) ) )
+        return {};
+
+    auto &&job = *fJobs[ index.row() ];
+    if ( role == Qt::TextAlignmentRole )
+    {
+        if ( ( index.column() == eFileName ) || ( index.column() == eState ) || ( index.column() == eMD5 ) )
+            return static_cast< int >( Qt::AlignLeft | Qt::AlignVCenter );
+        return static_cast< int >( Qt::AlignRight | Qt::AlignVCenter );
+    }
+    if ( role == Qt::ToolTipRole )
+    {
+        if ( index.column() == eFileName )
+            return fRelToDir.relativeFilePath( job.fFileName );
+        return {};
+    }
+    if ( role != Qt::DisplayRole )
+        return {};
+
+    switch ( index.column() )
+    {
+        case eThreadID:
+            return QString( "%1" ).arg( job.fThreadID.load( std::memory_order_relaxed ), 5, 10, QChar( '0' ) );
+        case eFileName:
+            return QFileInfo( job.fFileName ).fileName();
+        case eState:
+            return job.stateName();
+        case eSize:
+            return NSABUtils::NFileUtils::byteSizeString( job.fSize );
+        case ePosition:
+            if ( job.state() != CScanProgress::EJobState::eReading )
+                return {};
+            return tr( "%1 (%2%)" ).arg( NSABUtils::NFileUtils::byteSizeString( job.fPos.load( std::memory_order_relaxed ) ) ).arg( static_cast< int >( job.percentage() ), 2 );
+        case eCurrentRuntime:
+            return NSABUtils::CTimeString( job.currentRuntime( fNow ) ).toString();
+        case eRuntime:
+            return NSABUtils::CTimeString( job.runtime( fNow ) ).toString();
+        case eMD5:
+            return job.md5();
+        default:
+            return {};
+    }
+}
+
+QVariant CJobStatusModel::headerData( int section, Qt::Orientation orientation, int role ) const
+{
+    if ( ( orientation != Qt::Horizontal ) || ( role != Qt::DisplayRole ) )
+        return QAbstractTableModel::headerData( section, orientation, role );
+
+    switch ( section )
+    {
+        case eThreadID:
+            return tr( "Thread" );
+        case eFileName:
+            return tr( "File Name" );
+        case eState:
+            return tr( "State" );
+        case eSize:
+            return tr( "Size" );
+        case ePosition:
+            return tr( "File Position" );
+        case eCurrentRuntime:
+            return tr( "Current Runtime" );
+        case eRuntime:
+            return tr( "Overall Runtime" );
+        case eMD5:
+            return tr( "MD5" );
+        default:
+            return {};
+    }
+}
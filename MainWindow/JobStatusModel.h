@@ -0,0 +1,56 @@
+#ifndef JOBSTATUSMODEL_H
+#define JOBSTATUSMODEL_H
+
+#include "ScanProgress.h"
+
+#include <QAbstractTableModel>
+#include <QDir>
+#include <memory>
+#include <vector>
+
+// The running hash jobs shown in the progress dialog
+// update() diffs the sampled jobs against the current rows, so only rows that come or go are inserted or removed,
+// and text is only formatted when the view asks for a visible cell
+class CJobStatusModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum EColumns
+    {
+        eThreadID,
+        eFileName,
+        eState,
+        eSize,
+        ePosition,
+        eCurrentRuntime,
+        eRuntime,
+        eMD5,
+        eNumColumns
+    };
+
+    enum class ESortBy
+    {
+        eFileSize,
+        eThreadID,
+        ePercentComplete
+    };
+
+    CJobStatusModel( QObject *parent );
+
+    void setRelToDir( const QDir &relToDir ) { fRelToDir = relToDir; }
+    void update( const std::vector< std::shared_ptr< const CScanProgress::SJob > > &jobs, ESortBy sortBy );
+
+    int rowCount( const QModelIndex &parent = QModelIndex() ) const override;
+    int columnCount( const QModelIndex &parent = QModelIndex() ) const override;
+    QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const override;
+    QVariant headerData( int section, Qt::Orientation orientation, int role = Qt::DisplayRole ) const override;
+
+private:
+    qint64 sortKey( const CScanProgress::SJob &job, ESortBy sortBy ) const;
+
+    QDir fRelToDir;
+    std::vector< std::shared_ptr< const CScanProgress::SJob > > fJobs;
+    qint64 fNow{ 0 };
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include "KeepPolicy.h"
+
+#include <QDir>
+#include <QObject>
+#include <QRegularExpression>
+
+CKeepPolicy::CKeepPolicy()
+{
+    setPolicy( defaultPolicy() );
+}
+
+QString CKeepPolicy::defaultPolicy()
+{
+    return "avoid-copies;oldest-ctime";
+}
+
+bool CKeepPolicy::isCopyName( const QString &path, QString *baseName )
+{
+    static QRegularExpression sRegExp( "^(?<basename>.*)\\s+\\(\\s*\\d+\\s*\\)$" );
+    static QRegularExpression sRegExp2( "^(?<basename>.*)\\s+\\-\\s+Copy$" );
+    static QRegularExpression sRegExp3( "^Copy of (?<basename>.*)$" );
+    Q_ASSERT( sRegExp.isValid() && sRegExp2.isValid() && sRegExp3.isValid() );
+
+    auto fileName = path.mid( path.lastIndexOf( '/' ) + 1 );
+    auto dotPos = fileName.lastIndexOf( '.' );
+    auto completeBaseName = ( dotPos > 0 ) ? fileName.left( dotPos ) : fileName;
+    // most names are not copies, they are rejected without running the regular expressions
+    if ( !completeBaseName.endsWith( ')' ) && !completeBaseName.endsWith( "Copy" ) && !completeBaseName.startsWith( "Copy of " ) )
+        return false;
+
+    for ( auto &&regExp : { &sRegExp, &sRegExp2, &sRegExp3 } )
+    {
+        auto match = regExp->match( completeBaseName );
+        if ( !match.hasMatch() )
+            continue;
+        if ( baseName )
+            *baseName = match.captured( "basename" );
+        return true;
+    }
+    return false;
+}
+
+std::optional< CKeepPolicy::TKeyFunc > CKeepPolicy::compileRule( const QString &rule, QString *errorMsg )
+{
+    auto name = rule.section( ':', 0, 0 ).trimmed().toLower();
+    auto arg = rule.section( ':', 1 ).trimmed();
+
+    if ( ( name == "prefer-path" ) || ( name == "avoid-path" ) )
+    {
+        if ( arg.isEmpty() )
+        {
+            if ( errorMsg )
+                *errorMsg = QObject::tr( "Rule '%1' requires a path" ).arg( name );
+            return {};
+        }
+        auto prefix = QDir::cleanPath( QDir::fromNativeSeparators( arg ) );
+        if ( !prefix.endsWith( '/' ) )
+            prefix += '/';
+        bool prefer = ( name == "prefer-path" );
+        return [ prefix, prefer ]( const SFileMeta &file ) -> qint64
+        {
+            bool under = file.fPath.startsWith( prefix, Qt::CaseInsensitive );
+            return ( under == prefer ) ? 0 : 1;
+        };
+    }
+    if ( name == "shortest-path" )
+        return []( const SFileMeta &file ) -> qint64 { return file.fPath.length(); };
+    if ( name == "longest-path" )
+        return []( const SFileMeta &file ) -> qint64 { return -file.fPath.length(); };
+    if ( name == "newest-mtime" )
+        return []( const SFileMeta &file ) -> qint64 { return -file.fMTime; };
+    if ( name == "oldest-mtime" )
+        return []( const SFileMeta &file ) -> qint64 { return file.fMTime; };
+    if ( name == "newest-ctime" )
+        return []( const SFileMeta &file ) -> qint64 { return -file.fCTime; };
+    if ( name == "oldest-ctime" )
+        return []( const SFileMeta &file ) -> qint64 { return file.fCTime; };
+    if ( name == "avoid-copies" )
+        return []( const SFileMeta &file ) -> qint64 { return isCopyName( file.fPath ) ? 1 : 0; };
+
+    if ( errorMsg )
+        *errorMsg = QObject::tr( "Unknown keep policy rule '%1'" ).arg( rule );
+    return {};
+}
+
+bool CKeepPolicy::setPolicy( const QString &policy, QString *errorMsg )
+{
+    std::vector< TKeyFunc > rules;
+    auto ruleStrs = policy.split( ';', Qt::SkipEmptyParts );
+    for ( auto &&ii : ruleStrs )
+    {
+        if ( ii.trimmed().isEmpty() )
+            continue;
+        auto rule = compileRule( ii, errorMsg );
+        if ( !rule.has_value() )
+            return false;
+        rules.push_back( rule.value() );
+    }
+
+    fPolicy = policy;
+    fRules = std::move( rules );
+    return true;
+}
+
+int CKeepPolicy::survivor( const std::vector< SFileMeta > &files ) const
+{
+    if ( files.empty() )
+        return -1;
+
+    // compute every key once, then a single pass to find the minimum
+    auto numRules = fRules.size();
+    std::vector< qint64 > keys( files.size() * numRules );
+    for ( size_t ii = 0; ii < files.size(); ++ii )
+    {
+        for ( size_t jj = 0; jj < numRules; ++jj )
+            keys[ ii * numRules + jj ] = fRules[ jj ]( files[ ii ] );
+    }
+
+    size_t best = 0;
+    for ( size_t ii = 1; ii < files.size(); ++ii )
+    {
+        int cmp = 0;
+        for ( size_t jj = 0; ( cmp == 0 ) && ( jj < numRules ); ++jj )
+        {
+            auto lhs = keys[ ii * numRules + jj ];
+            auto rhs = keys[ best * numRules + jj ];
+            cmp = ( lhs < rhs ) ? -1 : ( ( lhs > rhs ) ? 1 : 0 );
+        }
+        if ( cmp == 0 )   // deterministic final tie-breaker
+            cmp = files[ ii ].fPath.compare( files[ best ].fPath );
+        if ( cmp < 0 )
+            best = ii;
+    }
+    return static_cast< int >( best );
+}
+
+std::vector< size_t > CKeepPolicy::filesToDelete( const std::vector< SFileMeta > &files ) const
+{
+    std::vector< size_t > retVal;
+    auto keep = survivor( files );
+    if ( keep < 0 )
+        return retVal;
+
+    retVal.reserve( files.size() - 1 );
+    for ( size_t ii = 0; ii < files.size(); ++ii )
+    {
+        if ( ii != static_cast< size_t >( keep ) )
+            retVal.push_back( ii );
+    }
+    return retVal;
+}
@@ -0,0 +1,56 @@
+#ifndef KEEPPOLICY_H
+#define KEEPPOLICY_H
+
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <optional>
+#include <vector>
+
+// metadata captured when the file was found, the policy never touches the filesystem
+struct SFileMeta
+{
+    QString fPath;   // absolute path
+    qint64 fSize{ 0 };
+    qint64 fMTime{ 0 };   // msecs since epoch
+    qint64 fCTime{ 0 };   // msecs since epoch
+};
+
+// An ordered list of rules used to choose the one file to keep in each duplicate group
+// Each rule is compiled into a key function, lower keys win, later rules only break ties of earlier ones
+//
+// Rules are separated by ';'
+//    prefer-path:<prefix>  - prefer files under the prefix
+//    avoid-path:<prefix>   - prefer files NOT under the prefix
+//    shortest-path         - prefer the shortest path
+//    longest-path          - prefer the longest path
+//    newest-mtime          - prefer the most recently modified
+//    oldest-mtime          - prefer the least recently modified
+//    newest-ctime          - prefer the most recently changed/created
+//    oldest-ctime          - prefer the least recently changed/created
+//    avoid-copies          - prefer files whose name is not "X (N)", "X - Copy" or "Copy of X"
+class CKeepPolicy
+{
+public:
+    CKeepPolicy();
+
+    static QString defaultPolicy();
+    static bool isCopyName( const QString &path, QString *baseName = nullptr );
+
+    bool setPolicy( const QString &policy, QString *errorMsg = nullptr );
+    QString policy() const { return fPolicy; }
+
+    // returns the index of the file to keep, -1 if files is empty
+    int survivor( const std::vector< SFileMeta > &files ) const;
+    // returns the indexes of every file but the survivor
+    std::vector< size_t > filesToDelete( const std::vector< SFileMeta > &files ) const;
+
+private:
+    using TKeyFunc = std::function< qint64( const SFileMeta & ) >;
+    static std::optional< TKeyFunc > compileRule( const QString &rule, QString *errorMsg );
+
+    QString fPolicy;
+    std::vector< TKeyFunc > fRules;
+};
+
+#endif
@@ -2,21 +2,32 @@
 #include "MainWindow.h"
 #include "ui_MainWindow.h"
 #include "FileFinder.h"
+#include "ScanSnapshot.h"
+#include "DirWatcher.h"
+#include "ResultsFile.h"
+#include "DupeModel.h"
+#include "IconLoader.h"
+#include "ScanProgress.h"
+#include "ConcurrencyController.h"
+#include "HashPipeline.h"
+#include "ChunkIndex.h"
+#include "ImageIndex.h"
+#include "NameMatcher.h"
+#include "DuplicateDirs.h"
+#include "SimilarFilesDlg.h"
 
 #include "ProgressDlg.h"
-#include "SABUtils/MD5.h"
 #include "SABUtils/ButtonEnabler.h"
 #include "SABUtils/utils.h"
 
 #include "SABUtils/FileUtils.h"
 #include "SABUtils/DelayLineEdit.h"
 
+#include <QApplication>
 #include <QFileDialog>
-#include <QStandardItemModel>
 #include <QSettings>
 #include <QProgressBar>
 #include <QDirIterator>
-#include <QSortFilterProxyModel>
 #include <QRegularExpression>
 #include <QProgressDialog>
 #include <QMessageBox>
@@ -28,65 +39,13 @@
 #include <QDesktopServices>
 #include <QInputDialog>
 #include <QMenu>
+#include <QHeaderView>
 
-#include <random>
 #include <unordered_set>
 
-class CFilterModel : public QSortFilterProxyModel
-{
-public:
-    CFilterModel( QObject *owner ) :
-        QSortFilterProxyModel( owner )
-    {
-    }
-    void setShowDupesOnly( bool showDupesOnly )
-    {
-        if ( showDupesOnly != fShowDupesOnly )
-        {
-            fShowDupesOnly = showDupesOnly;
-            invalidate();
-        }
-    }
-
-    void setLoadingValues( bool loading )
-    {
-        if ( loading != fLoadingValues )
-        {
-            fLoadingValues = loading;
-            invalidate();
-        }
-    }
-
-    virtual bool filterAcceptsRow( int source_row, const QModelIndex &source_parent ) const override
-    {
-        if ( source_parent.isValid() )
-            return true;   // all children are visible if parent is
-
-        if ( !fShowDupesOnly )
-            return true;
-
-        QModelIndex sourceIdx = sourceModel()->index( source_row, 0, source_parent );
-        auto childCount = sourceModel()->rowCount( sourceIdx );
-        return childCount > 1;
-    }
-
-    virtual void sort( int column, Qt::SortOrder order = Qt::AscendingOrder ) override
-    {
-        if ( fLoadingValues )
-            return;
-
-        if ( column == 1 )
-            setSortRole( Qt::UserRole + 1 );
-        else
-            setSortRole( Qt::DisplayRole );
-        QSortFilterProxyModel::sort( column, order );
-    }
-
-    virtual bool lessThan( const QModelIndex &source_left, const QModelIndex &source_right ) const override { return source_left.data().toInt() < source_right.data().toInt(); }
-
-    bool fLoadingValues{ false };
-    bool fShowDupesOnly{ true };
-};
+constexpr int sCheckpointInterval = 5 * 60 * 1000;   // msecs
+constexpr int sHashBuffers = 64;
+constexpr qint64 sHashBufferSize = 1024 * 1024;
 
 CMainWindow::CMainWindow( QWidget *parent ) :
     QMainWindow( parent ),
@@ -111,12 +70,11 @@ CMainWindow::CMainWindow( QWidget *parent ) :
     setWindowIcon( QIcon( ":/resources/finddupe.png" ) );
     setAttribute( Qt::WA_DeleteOnClose );
 
-    fModel = new QStandardItemModel( this );
-    initModel();
-    fFilterModel = new CFilterModel( this );
-    fFilterModel->setSourceModel( fModel );
-    fImpl->files->setModel( fFilterModel );
+    fModel = new CDupeModel( this );
+    fImpl->files->setModel( fModel );
+    fImpl->files->setUniformRowHeights( true );
     fImpl->files->setIconSize( QSize( 100, 100 ) );
+    fModel->setIconLoader( new CIconLoader( fImpl->files->iconSize(), this ) );
     fImpl->files->setContextMenuPolicy( Qt::CustomContextMenu );
 
     connect( fImpl->files, &QTreeView::doubleClicked, this, &CMainWindow::slotFileDoubleClicked );
@@ -128,6 +86,8 @@ CMainWindow::CMainWindow( QWidget *parent ) :
     connect( fImpl->go, &QToolButton::clicked, this, &CMainWindow::slotGo );
     connect( fImpl->del, &QToolButton::clicked, this, &CMainWindow::slotDelete );
     connect( fImpl->selectDir, &QToolButton::clicked, this, &CMainWindow::slotSelectDir );
+    connect( fImpl->actionOpenResults, &QAction::triggered, this, &CMainWindow::slotLoadResults );
+    connect( fImpl->actionSaveResults, &QAction::triggered, this, &CMainWindow::slotSaveResults );
 
     connect( fImpl->dirName, &NSABUtils::CDelayComboBox::sigEditTextChangedAfterDelay, this, &CMainWindow::slotDirChanged );
     connect( fImpl->dirName, &NSABUtils::CDelayComboBox::editTextChanged, this, &CMainWindow::slotDirChanged );
@@ -139,6 +99,13 @@ CMainWindow::CMainWindow( QWidget *parent ) :
 
     connect( fImpl->ignoreFilesOver, &QCheckBox::clicked, this, &CMainWindow::slotIgnoreFilesOver );
     connect( fImpl->ignoreFilesOverValue, qOverload< int >( &QSpinBox::valueChanged ), this, &CMainWindow::slotIgnoreFilesOver );
+    connect( fImpl->hashLargeFilesOver, &QCheckBox::clicked, this, &CMainWindow::slotHashLargeFilesOver );
+    connect( fImpl->largeFileMode, qOverload< int >( &QComboBox::currentIndexChanged ), this, &CMainWindow::slotHashLargeFilesOver );
+    connect( fImpl->findSimilarImages, &QCheckBox::clicked, fImpl->similarImagesDistance, &QSpinBox::setEnabled );
+    connect( fImpl->caseInsensitiveNameCompare, &QCheckBox::clicked, fImpl->nameMatchKey, &QComboBox::setEnabled );
+    connect( fImpl->caseInsensitiveNameCompare, &QCheckBox::clicked, fImpl->nameMatchIgnoreCopies, &QCheckBox::setEnabled );
+
+    connect( fImpl->keepPolicy, &QLineEdit::editingFinished, this, &CMainWindow::slotKeepPolicyChanged );
 
     connect( fImpl->addPathName, &QToolButton::clicked, this, &CMainWindow::slotAddIgnoredPathName );
     connect( fImpl->delPathName, &QToolButton::clicked, this, &CMainWindow::slotDelIgnoredPathName );
@@ -158,10 +125,31 @@ CMainWindow::CMainWindow( QWidget *parent ) :
     settings.remove( "Dir" );
     fImpl->dirName->addItems( dirs );
     fImpl->showDupesOnly->setChecked( settings.value( "ShowDupesOnly", true ).toBool() );
+    fModel->setShowDupesOnly( fImpl->showDupesOnly->isChecked() );
     fImpl->ignoreHidden->setChecked( settings.value( "IgnoreHidden", true ).toBool() );
     fImpl->ignoreFilesOver->setChecked( settings.value( "IgnoreFilesOver", true ).toBool() );
     fImpl->ignoreFilesOverValue->setValue( settings.value( "IgnoreFilesOverValue", 1000 ).toInt() );
+    fImpl->hashLargeFilesOver->setChecked( settings.value( "HashLargeFilesOver", false ).toBool() );
+    fImpl->hashLargeFilesOverValue->setValue( settings.value( "HashLargeFilesOverValue", 1000 ).toInt() );
+    fImpl->largeFileMode->setCurrentIndex( settings.value( "LargeFileMode", 0 ).toInt() );
+    fImpl->similarFilesPercent->setValue( settings.value( "SimilarFilesPercent", 80 ).toInt() );
+    slotHashLargeFilesOver();
+    fImpl->findSimilarImages->setChecked( settings.value( "FindSimilarImages", false ).toBool() );
+    fImpl->similarImagesDistance->setValue( settings.value( "SimilarImagesDistance", 6 ).toInt() );
+    fImpl->similarImagesDistance->setEnabled( fImpl->findSimilarImages->isChecked() );
+    fImpl->findDuplicateDirs->setChecked( settings.value( "FindDuplicateDirs", false ).toBool() );
+    fImpl->smallFilesUnder->setValue( settings.value( "SmallFilesUnder", 4 ).toInt() );
     fImpl->caseInsensitiveNameCompare->setChecked( settings.value( "CaseInsensitiveCompare", false ).toBool() );
+    fImpl->nameMatchKey->setCurrentIndex( settings.value( "NameMatchKey", 0 ).toInt() );
+    fImpl->nameMatchIgnoreCopies->setChecked( settings.value( "NameMatchIgnoreCopies", false ).toBool() );
+    fImpl->nameMatchKey->setEnabled( fImpl->caseInsensitiveNameCompare->isChecked() );
+    fImpl->nameMatchIgnoreCopies->setEnabled( fImpl->caseInsensitiveNameCompare->isChecked() );
+    fImpl->incrementalRescan->setChecked( settings.value( "IncrementalRescan", true ).toBool() );
+    fImpl->watchForChanges->setChecked( settings.value( "WatchForChanges", false ).toBool() );
+    fImpl->scanFilter->setText( settings.value( "ScanFilter", QString() ).toString() );
+    fImpl->keepPolicy->setText( settings.value( "KeepPolicy", CKeepPolicy::defaultPolicy() ).toString() );
+    if ( !fKeepPolicy.setPolicy( fImpl->keepPolicy->text() ) )
+        fImpl->keepPolicy->setText( fKeepPolicy.policy() );
     addIgnoredPathNames( settings
                              .value(
                                  "IgnoredPathNames", QStringList() << "poster.jpg"
@@ -179,16 +167,31 @@ CMainWindow::CMainWindow( QWidget *parent ) :
     fImpl->files->setColumnWidth( 0, 100 );
 
     threadPool()->setExpiryTimeout( -1 );
+    fConcurrency = new CConcurrencyController( threadPool(), hashPipeline()->numBuffers(), this );   // every reader beyond the pipeline's buffers would only wait for one
 
+    qRegisterMetaType< SDigest >( "SDigest" );
+    qRegisterMetaType< SHashedFile >( "SHashedFile" );
+    qRegisterMetaType< THashedFiles >( "THashedFiles" );
     fFileFinder = new CFileFinder( this );
     connect( this, &CMainWindow::sigMD5FileFinished, this, &CMainWindow::slotMD5FileFinished );
-
-    connect( fFileFinder, &CFileFinder::sigMD5FileStarted, this, &CMainWindow::sigMD5FileStarted );
-    connect( fFileFinder, &CFileFinder::sigMD5ReadPositionStatus, this, &CMainWindow::sigMD5ReadPositionStatus );
-    connect( fFileFinder, &CFileFinder::sigMD5FileFinishedReading, this, &CMainWindow::sigMD5FileFinishedReading );
-    connect( fFileFinder, &CFileFinder::sigMD5FileFinishedComputing, this, &CMainWindow::sigMD5FileFinishedComputing );
     connect( fFileFinder, &CFileFinder::sigMD5FileFinished, this, &CMainWindow::sigMD5FileFinished );
+    connect( fFileFinder, &CFileFinder::sigSmallFilesFinished, this, &CMainWindow::slotSmallFilesFinished );
     connect( fFileFinder, &CFileFinder::sigDirFinished, this, &CMainWindow::slotFindDirFinished );
+
+    fWatchFinder = new CFileFinder( this );
+    fDirWatcher = new CDirWatcher( fWatchFinder, this );
+    connect( fWatchFinder, &CFileFinder::sigMD5FileFinished, this, &CMainWindow::slotMD5FileFinished );
+    connect( fWatchFinder, &CFileFinder::sigSmallFilesFinished, this, &CMainWindow::slotSmallFilesFinished );
+    connect( fWatchFinder, &CFileFinder::sigFileRemoved, this, &CMainWindow::slotFileRemoved );
+    connect( fWatchFinder, &CFileFinder::sigDirRemoved, this, &CMainWindow::slotDirRemoved );
+    connect( fFileFinder, &CFileFinder::sigDirFinished, fDirWatcher, &CDirWatcher::slotAddDir );
+    connect( fFileFinder, &CFileFinder::sigFileChanged, fDirWatcher, &CDirWatcher::slotFileChanged );
+    connect( fDirWatcher, &CDirWatcher::sigRescanFinished, this, &CMainWindow::slotRescanFinished );
+    connect( fImpl->watchForChanges, &QCheckBox::clicked, this, &CMainWindow::slotWatchForChanges );
+
+    fCheckpointTimer = new QTimer( this );
+    fCheckpointTimer->setInterval( sCheckpointInterval );
+    connect( fCheckpointTimer, &QTimer::timeout, this, &CMainWindow::slotCheckpoint );
 }
 
 void CMainWindow::slotFindDirFinished( const QString &dirName )
@@ -220,21 +223,39 @@ void CMainWindow::addIgnoredPathName( const QString &ignoredFileName )
     addIgnoredPathNames( QStringList() << ignoredFileName );
 }
 
-void CMainWindow::initModel()
+void CMainWindow::initModel( const QString &rootDir )
 {
-    fModel->clear();
-    fModel->setHorizontalHeaderLabels( QStringList() << tr( "FileName" ) << tr( "Timestamp" ) << tr( "Count" ) << tr( "Size" ) << tr( "MD5" ) );
+    fModel->clear( rootDir );
+    fModelRootDir = rootDir.isEmpty() ? QString() : QDir::cleanPath( rootDir );
 }
 
 CMainWindow::~CMainWindow()
 {
+    fDirWatcher->stop();
+    if ( fSnapshot )
+        fSnapshot->save( false );
+
     QSettings settings;
     settings.setValue( "Dirs", fImpl->dirName->getAllText() );
     settings.setValue( "ShowDupesOnly", fImpl->showDupesOnly->isChecked() );
     settings.setValue( "IgnoreHidden", fImpl->ignoreHidden->isChecked() );
     settings.setValue( "IgnoreFilesOver", fImpl->ignoreFilesOver->isChecked() );
     settings.setValue( "IgnoreFilesOverValue", fImpl->ignoreFilesOverValue->value() );
+    settings.setValue( "HashLargeFilesOver", fImpl->hashLargeFilesOver->isChecked() );
+    settings.setValue( "HashLargeFilesOverValue", fImpl->hashLargeFilesOverValue->value() );
+    settings.setValue( "LargeFileMode", fImpl->largeFileMode->currentIndex() );
+    settings.setValue( "SimilarFilesPercent", fImpl->similarFilesPercent->value() );
+    settings.setValue( "FindSimilarImages", fImpl->findSimilarImages->isChecked() );
+    settings.setValue( "SimilarImagesDistance", fImpl->similarImagesDistance->value() );
+    settings.setValue( "FindDuplicateDirs", fImpl->findDuplicateDirs->isChecked() );
+    settings.setValue( "SmallFilesUnder", fImpl->smallFilesUnder->value() );
     settings.setValue( "CaseInsensitiveCompare", fImpl->caseInsensitiveNameCompare->isChecked() );
+    settings.setValue( "NameMatchKey", fImpl->nameMatchKey->currentIndex() );
+    settings.setValue( "NameMatchIgnoreCopies", fImpl->nameMatchIgnoreCopies->isChecked() );
+    settings.setValue( "IncrementalRescan", fImpl->incrementalRescan->isChecked() );
+    settings.setValue( "WatchForChanges", fImpl->watchForChanges->isChecked() );
+    settings.setValue( "ScanFilter", fImpl->scanFilter->text() );
+    settings.setValue( "KeepPolicy", fKeepPolicy.policy() );
 
     auto ignoredPathNames = getIgnoredPathNames();
     QStringList fileNames;
@@ -245,19 +266,21 @@ CMainWindow::~CMainWindow()
 
 QThreadPool *CMainWindow::threadPool()
 {
+    // sized by CConcurrencyController
     static QThreadPool retVal;
-    static bool first = true;
-    if ( first )
-    {
-        retVal.setMaxThreadCount( retVal.maxThreadCount() * 3 );
-        first = false;
-    }
+    return &retVal;
+}
+
+CHashPipeline *CMainWindow::hashPipeline()
+{
+    static CHashPipeline retVal( sHashBuffers, sHashBufferSize );
     return &retVal;
 }
 
 void CMainWindow::slotShowDupesOnly()
 {
-    fFilterModel->setShowDupesOnly( fImpl->showDupesOnly->isChecked() );
+    fModel->setShowDupesOnly( fImpl->showDupesOnly->isChecked() );
+    fImpl->del->setEnabled( hasDuplicates() );
 }
 
 void CMainWindow::slotIgnoreFilesOver()
@@ -267,6 +290,33 @@ void CMainWindow::slotIgnoreFilesOver()
         fFileFinder->setIgnoreFilesOver( fImpl->ignoreFilesOver->isChecked(), fImpl->ignoreFilesOverValue->value() );
 }
 
+void CMainWindow::slotHashLargeFilesOver()
+{
+    fImpl->hashLargeFilesOverValue->setEnabled( fImpl->hashLargeFilesOver->isChecked() );
+    fImpl->largeFileMode->setEnabled( fImpl->hashLargeFilesOver->isChecked() );
+    fImpl->similarFilesPercent->setEnabled( fImpl->hashLargeFilesOver->isChecked() );
+}
+
+void CMainWindow::slotKeepPolicyChanged()
+{
+    if ( fImpl->keepPolicy->text() == fKeepPolicy.policy() )
+        return;
+
+    QString errorMsg;
+    if ( !fKeepPolicy.setPolicy( fImpl->keepPolicy->text(), &errorMsg ) )
+    {
+        QMessageBox::critical( this, tr( "Invalid Keep Policy" ), errorMsg );
+        fImpl->keepPolicy->setText( fKeepPolicy.policy() );
+        return;
+    }
+
+    for ( size_t ii = 0; ii < fModel->numGroups(); ++ii )
+    {
+        if ( fModel->groupFileCount( ii ) > 1 )
+            applyKeepPolicy( ii );
+    }
+}
+
 void CMainWindow::slotSelectDir()
 {
     auto dir = QFileDialog::getExistingDirectory( this, "Select Directory", fImpl->dirName->currentText() );
@@ -278,7 +328,8 @@ void CMainWindow::slotSelectDir()
 
 void CMainWindow::slotDirChanged()
 {
-    initModel();
+    if ( QDir::cleanPath( fImpl->dirName->currentText() ) != fModelRootDir )
+        initModel( QString() );
     QFileInfo fi( fImpl->dirName->currentText() );
     QString msg;
     if ( !fi.exists() )
@@ -289,134 +340,75 @@ void CMainWindow::slotDirChanged()
     fImpl->go->setEnabled( fi.exists() && fi.isDir() );
 }
 
-QList< QStandardItem * > CMainWindow::createFileRow( const QFileInfo &fi, const QString &md5 )
+void CMainWindow::slotMD5FileFinished( unsigned long long /*threadID*/, const QDateTime & /*endTime*/, const SHashedFile &file )
 {
-    if ( fi.size() == 0 )
-        return {};
+    qDebug() << "Finished MD5 Computation: " << file.fMeta.fPath << "MD5=" << file.fDigest.toHex();
 
-    if ( md5.isEmpty() )
-        qDebug() << "Creating file row for file" << fi << " MD5 already existed";
-    else
-        qDebug() << "Creating MD5 Header for file" << fi << "MD5: " << md5;
-    bool header = !md5.isEmpty();
-
-    auto relToDir = QDir( fImpl->dirName->currentText() );
-
-    auto rootFNItem = new QStandardItem( relToDir.relativeFilePath( fi.absoluteFilePath() ) );
-    QStandardItem *tsItem = nullptr;
-    QStandardItem *md5Item = nullptr;
-    QStandardItem *countItem = nullptr;
-    QStandardItem *sizeItem = nullptr;
-
-    if ( header )
-    {
-        countItem = new QStandardItem( QString() );
+    if ( fModel->hasFile( file.fMeta.fPath ) )
+        return;   // already in the results, a rescan of an unchanged file
 
-        sizeItem = new QStandardItem( NSABUtils::NFileUtils::byteSizeString( fi ) );
-        sizeItem->setTextAlignment( Qt::AlignmentFlag::AlignRight | Qt::AlignmentFlag::AlignVCenter );
-        setFileCount( countItem, 0 );
+    if ( file.fMeta.fSize == 0 )
+        return;
 
-        md5Item = new QStandardItem( md5 );
-        md5Item->setTextAlignment( Qt::AlignmentFlag::AlignRight | Qt::AlignmentFlag::AlignVCenter );
-        md5Item->setFont( QFontDatabase::systemFont( QFontDatabase::FixedFont ) );
-    }
-    else
-    {
-        auto timeStamp = fi.lastModified().toString();
-        tsItem = new QStandardItem( timeStamp );
-        tsItem->setTextAlignment( Qt::AlignmentFlag::AlignRight | Qt::AlignmentFlag::AlignVCenter );
-    }
+    if ( addHashedFile( file.fDigest, file.fMeta ) )
+        updateResultsLabel();
 
-    auto row = QList< QStandardItem * >() << rootFNItem << tsItem << countItem << sizeItem << md5Item;
-    return row;
+    if ( fProgress )
+        fProgress->setNumDuplicates( fDupesFound );
 }
 
-void CMainWindow::slotMD5FileFinished( unsigned long long /*threadID*/, const QDateTime & /*endTime*/, const QString &fileName, const QString &md5 )
+void CMainWindow::slotSmallFilesFinished( const THashedFiles &files )
 {
-    qDebug() << "Finished MD5 Computation: " << fileName << "MD5=" << md5;
-    fMD5FilesComputed++;
-    if ( fProgress )
-        fProgress->setMD5Value( fMD5FilesComputed );
-
-    if ( md5.isEmpty() )
-        return;
-
-    auto fi = QFileInfo( fileName );
-    if ( fi.size() == 0 )
-        return;
-
-    auto pos = fMap.find( md5 );
-    QStandardItem *rootItem = nullptr;
-    QStandardItem *countItem = nullptr;
-    if ( pos == fMap.end() )
-    {
-        auto row = createFileRow( fi, md5 );
-        if ( row.empty() )
-            return;
-
-        rootItem = row[ 0 ];
-        countItem = row[ 2 ];
-        fMap[ md5 ] = { rootItem, countItem };
-        fModel->appendRow( row );
-    }
-    else
+    bool dupesFound = false;
+    for ( auto &&ii : files )
     {
-        std::tie( rootItem, countItem ) = ( *pos ).second;
+        if ( !fModel->hasFile( ii.fMeta.fPath ) && addHashedFile( ii.fDigest, ii.fMeta ) )
+            dupesFound = true;
     }
-
-    auto newCount = fileCount( rootItem ) + 1;
-    setFileCount( countItem, newCount );
-    countItem->setText( QString::number( newCount ) );
-
-    if ( !hasChildFile( rootItem, fi ) )
-    {
-        auto childRow = createFileRow( fi, QString() );
-        rootItem->appendRow( childRow );
-    }
-
-    if ( newCount > 1 )
-    {
-        fDupesFound.first++;
-        fDupesFound.second += QFileInfo( fileName ).size();
+    if ( dupesFound )
         updateResultsLabel();
-        determineFilesToDeleteRoot( rootItem );
-    }
 
-    auto srcIdx = fModel->indexFromItem( rootItem );
-    if ( srcIdx.isValid() )
-    {
-        auto idx = fFilterModel->mapFromSource( srcIdx );
-        if ( idx.isValid() )
-            fImpl->files->setExpanded( idx, true );
-    }
     if ( fProgress )
         fProgress->setNumDuplicates( fDupesFound );
 }
 
-bool CMainWindow::hasChildFile( QStandardItem *header, const QFileInfo &fi ) const
+bool CMainWindow::addHashedFile( const SDigest &digest, const SFileMeta &meta )
 {
-    for ( int ii = 0; ii < header->rowCount(); ++ii )
-    {
-        auto child = header->child( ii, 0 );
-        if ( getFileInfo( child ).absoluteFilePath() == fi.absoluteFilePath() )
-            return true;
-    }
-    return false;
+    auto group = fModel->addFile( digest, meta );
+    if ( !group.has_value() || ( fModel->groupFileCount( group.value() ) < 2 ) )
+        return false;
+
+    fDupesFound.first++;
+    fDupesFound.second += meta.fSize;
+    applyKeepPolicy( group.value() );
+    return true;
 }
 
-QFileInfo CMainWindow::getFileInfo( QStandardItem *item ) const
+void CMainWindow::slotFileRemoved( const QString &fileName )
 {
-    if ( item->column() != 0 )
+    auto group = fModel->groupForFile( fileName );
+    if ( !group.has_value() )
+        return;
+
+    auto oldCount = fModel->groupFileCount( group.value() );
+    auto removed = fModel->removeFile( fileName );
+    if ( !removed.has_value() )
+        return;
+
+    if ( oldCount > 1 )
     {
-        auto idx = fModel->indexFromItem( item );
-        idx = fModel->index( idx.row(), 0, idx.parent() );
-        item = fModel->itemFromIndex( idx );
+        fDupesFound.first--;
+        fDupesFound.second -= removed.value().fSize;
     }
+    if ( fModel->groupFileCount( group.value() ) > 0 )
+        applyKeepPolicy( group.value() );
+    updateResultsLabel();
+}
 
-    auto fn = item->text();
-    auto rootDir = QDir( fImpl->dirName->currentText() );
-    QFileInfo fi( rootDir.absoluteFilePath( fn ) );
-    return fi;
+void CMainWindow::slotDirRemoved( const QString &dirName )
+{
+    for ( auto &&ii : fModel->filesUnder( dirName ) )
+        slotFileRemoved( ii );
 }
 
 NSABUtils::TCaseInsensitiveHash CMainWindow::getIgnoredPathNames() const
@@ -429,72 +421,32 @@ NSABUtils::TCaseInsensitiveHash CMainWindow::getIgnoredPathNames() const
     return ignoredFileNames;
 }
 
-int CMainWindow::fileCount( int row ) const
-{
-    auto item = fModel->item( row, 0 );
-    return fileCount( item );
-}
-
-int CMainWindow::fileCount( QStandardItem *item ) const
-{
-    if ( !item )
-        return 0;
-    return item->rowCount();
-}
-
-void CMainWindow::setFileCount( int row, int cnt )
-{
-    auto item = fModel->item( row, 1 );
-    return setFileCount( item, cnt );
-}
-
-void CMainWindow::setFileCount( QStandardItem *item, int cnt )
-{
-    if ( !item )
-        return;
-    return item->setData( cnt, Qt::UserRole + 1 );
-}
-
 void CMainWindow::slotFileDoubleClicked( const QModelIndex &idx )
 {
-    auto srcIdx = fFilterModel->mapToSource( idx );
-    auto item = fModel->itemFromIndex( srcIdx );
-    if ( !item )
+    auto path = fModel->filePath( idx );
+    if ( path.isEmpty() )
         return;
 
-    auto fi = getFileInfo( item );
-    auto dir = fi.absoluteDir();
-    auto path = dir.absolutePath();
-    auto url = QUrl::fromLocalFile( fi.absoluteFilePath() );
+    auto url = QUrl::fromLocalFile( path );
     QDesktopServices::openUrl( url );
 }
 
 void CMainWindow::slotFileContextMenu( const QPoint &pos )
 {
     auto idx = fImpl->files->indexAt( pos );
-    if ( !idx.isValid() )
-        return;
-
-    auto sourceIdx = fFilterModel->mapToSource( idx );
-    if ( !sourceIdx.isValid() )
+    auto group = fModel->groupForIndex( idx );
+    if ( !group.has_value() )
         return;
 
-    auto item = fModel->itemFromIndex( sourceIdx );
-    if ( !item )
-        return;
-
-    if ( item->parent() )
-        item = item->parent();
-
-    if ( !item->hasChildren() )
+    if ( fModel->groupFileCount( group.value() ) == 0 )
         return;
 
     QMenu menu;
     menu.addAction(
         "Delete Duplicates",
-        [ this, item ]()
+        [ this, group ]()
         {
-            auto filesToDelete = this->filesToDelete( item );
+            auto filesToDelete = fModel->filesToDelete( group.value() );
             deleteFiles( filesToDelete );
         } );
     menu.exec( fImpl->files->viewport()->mapToGlobal( pos ) );
@@ -502,33 +454,7 @@ void CMainWindow::slotFileContextMenu( const QPoint &pos )
 
 void CMainWindow::slotDelete()
 {
-    auto progress = std::make_unique< QProgressDialog >( tr( "Determining Files to Delete..." ), tr( "Cancel" ), 0, 0 );
-    auto bar = new QProgressBar;
-    bar->setFormat( "%v of %m - %p%" );
-    progress->setBar( bar );
-    progress->setAutoReset( false );
-    progress->setAutoClose( false );
-    progress->setWindowModality( Qt::WindowModal );
-    progress->setMinimumDuration( 1 );
-
-    auto rowCount = fFilterModel->rowCount();
-    progress->setRange( 0, rowCount );
-    QStringList filesToDelete;
-    for ( int ii = 0; ii < rowCount; ++ii )
-    {
-        progress->setValue( ii );
-        progress->setLabelText( tr( "Determining Files to Delete..." ) );
-        filesToDelete << this->filesToDelete( ii );
-        if ( ( progress->value() % 50 ) == 0 )
-        {
-            progress->adjustSize();
-        }
-        if ( progress->wasCanceled() )
-            break;
-    }
-    progress.reset();
-
-    deleteFiles( filesToDelete );
+    deleteFiles( fModel->filesToDelete() );
 
     fImpl->del->setEnabled( false );
 }
@@ -570,236 +496,20 @@ void CMainWindow::deleteFiles( const QStringList &filesToDelete )
     }
 }
 
-QStringList CMainWindow::filesToDelete( int ii )
-{
-    auto item = itemFromFilterRow( ii );
-    if ( !item )
-        return {};
-
-    return filesToDelete( item );
-}
-
-QStringList CMainWindow::filesToDelete( QStandardItem *item )
-{
-    QStringList retVal;
-    if ( deleteFile( item ) )
-        retVal << item->text();
-    auto childCount = item->rowCount();
-    for ( int ii = 0; ii < childCount; ++ii )
-    {
-        auto childItem = item->child( ii, 0 );
-        if ( deleteFile( childItem ) )
-            retVal << getFileInfo( childItem ).absoluteFilePath();
-    }
-    return retVal;
-}
-
-QStandardItem *CMainWindow::itemFromFilterRow( int ii )
-{
-    auto idx = fFilterModel->index( ii, 0 );
-    if ( !idx.isValid() )
-        return {};
-
-    auto sourceIdx = fFilterModel->mapToSource( idx );
-    if ( !sourceIdx.isValid() )
-        return {};
-
-    auto item = fModel->itemFromIndex( sourceIdx );
-    return item;
-}
-
-QList< QStandardItem * > findFilesToDelete( QStandardItem *item )
-{
-    QList< QStandardItem * > retVal;
-    std::random_device rd;
-    std::mt19937 gen( rd() );
-    std::uniform_int_distribution<> dis( 0, 1 + item->rowCount() );
-    int val = dis( gen );   // the one NOT to delete
-    for ( int ii = 0; ii < item->rowCount() + 1; ++ii )
-    {
-        if ( ii == val )
-            continue;
-
-        QStandardItem *currItem = nullptr;
-        if ( ii == 0 )
-            currItem = item;
-        else
-            currItem = item->child( ii - 1, 0 );
-
-        retVal << currItem;
-    }
-    return retVal;
-}
-
-QList< QStandardItem * > CMainWindow::getAllFiles( QStandardItem *rootFileFN ) const
-{
-    if ( !rootFileFN )
-        return {};
-
-    QList< QStandardItem * > retVal;
-    retVal << rootFileFN;
-
-    for ( auto ii = 0; ii < rootFileFN->rowCount(); ++ii )
-    {
-        auto child = rootFileFN->child( ii, 0 );
-        if ( !child )
-            continue;
-        retVal << child;
-    }
-
-    return retVal;
-}
-
-// returns true if lhs file is older than rhs file
-bool isOlder( QStandardItem *lhs, QStandardItem *rhs )
-{
-    if ( !lhs )
-        return false;
-    if ( !rhs )
-        return true;
-
-    auto lhsFile = QFileInfo( lhs->text() );
-    auto rhsFile = QFileInfo( rhs->text() );
-
-    return ( lhsFile.metadataChangeTime() < rhsFile.metadataChangeTime() );
-}
-
-QList< QStandardItem * > CMainWindow::determineFilesToDelete( QStandardItem *rootFileFN )
-{
-    QRegularExpression regExp( "^(?<basename>.*)\\s+\\(\\s*\\d+\\s*\\)$" );
-    Q_ASSERT( regExp.isValid() );
-    QRegularExpression regExp2( "^(?<basename>.*)\\s+\\-\\s+Copy$" );
-    Q_ASSERT( regExp2.isValid() );
-    QRegularExpression regExp3( "^Copy of (?<basename>.*)$" );
-    Q_ASSERT( regExp.isValid() );
-
-    std::unordered_map< QString, QStandardItem * > baseFiles;   // Files without the (N) in the name
-    QList< std::pair< QStandardItem *, QString > > copies;   // Files without the (N) in the name
-
-    auto files = getAllFiles( rootFileFN );
-    for ( int ii = 0; ii < files.count(); ++ii )
-    {
-        auto item = files[ ii ];
-        if ( !item )
-            continue;
-
-        auto fullName = item->text();
-        QFileInfo fi( item->text() );
-        auto baseName = fi.completeBaseName();
-
-        auto match = regExp.match( baseName, 0 );
-        auto match2 = regExp2.match( baseName, 0 );
-        auto match3 = regExp3.match( baseName, 0 );
-        if ( match.hasMatch() )
-        {
-            auto computedBaseName = fi.absolutePath() + "/" + match.captured( "basename" ) + "." + fi.suffix();
-            copies << std::make_pair( files[ ii ], computedBaseName );
-        }
-        else if ( match2.hasMatch() )
-        {
-            auto computedBaseName = fi.absolutePath() + "/" + match2.captured( "basename" ) + "." + fi.suffix();
-            copies << std::make_pair( files[ ii ], computedBaseName );
-        }
-        else if ( match3.hasMatch() )
-        {
-            auto computedBaseName = fi.absolutePath() + "/" + match3.captured( "basename" ) + "." + fi.suffix();
-            copies << std::make_pair( files[ ii ], computedBaseName );
-        }
-        else
-            baseFiles[ fullName ] = files[ ii ];
-    }
-
-    // for each "copy" see if the basefile is in the list
-    // if it is not move the copy to the base file list
-    QList< QStandardItem * > retVal;
-    for ( auto &&ii : copies )
-    {
-        auto pos = baseFiles.find( ii.second );
-        if ( pos != baseFiles.end() )
-        {
-            // a basefile exsts.. definately delete this one
-            retVal << ii.first;
-        }
-        else
-            baseFiles[ ii.second ] = ii.first;
-    }
-    if ( baseFiles.size() > 1 )   // more than one baseFile, pick the oldest one to keep.
-    {
-        QStandardItem *oldest = nullptr;
-        for ( auto &&curr : baseFiles )
-        {
-            if ( isOlder( curr.second, oldest ) )
-            {
-                oldest = curr.second;
-            }
-        }
-
-        for ( auto &&curr : baseFiles )
-        {
-            if ( curr.second == oldest )
-                continue;
-            retVal << curr.second;
-        }
-    }
-    return retVal;
-}
-
-void CMainWindow::determineFilesToDeleteRoot( QStandardItem *item )
+bool CMainWindow::hasDuplicates() const
 {
-    if ( !item )
-        return;
-
-    if ( item->parent() )
-        return;   // only done on the root filename
-
-    setDeleteFile( item, false, true );
-
-    auto filesToDelete = this->determineFilesToDelete( item );
-    for ( auto &&ii : filesToDelete )
-    {
-        setDeleteFile( ii, true, false );
-        ii->setBackground( Qt::red );
-        if ( ii->parent() )
-            ii->setCheckState( Qt::Checked );
-    }
+    return fModel->numVisibleGroups() > 0;
 }
 
-void CMainWindow::setDeleteFile( QStandardItem *item, bool deleteFile, bool handleChildren )
+void CMainWindow::applyKeepPolicy( size_t group )
 {
-    if ( !item )
-        return;
-
-    if ( !handleChildren )
-        return;
-
-    auto childCount = item->rowCount();
-    for ( int ii = 0; ii < childCount; ++ii )
-    {
-        auto child = item->child( ii );
-        if ( !child )
-            continue;
+    std::vector< SFileMeta > metas;
+    auto &&files = fModel->groupFiles( group );
+    metas.reserve( files.size() );
+    for ( auto &&ii : files )
+        metas.push_back( fModel->fileMeta( ii ) );
 
-        child->setCheckable( true );
-
-        setDeleteFile( child, deleteFile, false );
-    }
-}
-
-bool CMainWindow::deleteFile( QStandardItem *item ) const
-{
-    if ( !item )
-        return false;
-    if ( !item->isCheckable() )
-        return false;
-    if ( item->checkState() != Qt::Checked )
-        return false;
-
-    return true;
-}
-
-bool CMainWindow::hasDuplicates() const
-{
-    return fFilterModel->rowCount() > 0;
+    fModel->setFilesToDelete( group, fKeepPolicy.filesToDelete( metas ) );
 }
 
 void CMainWindow::slotCountDirFinished( const QString &dirName )
@@ -807,33 +517,38 @@ void CMainWindow::slotCountDirFinished( const QString &dirName )
     qDebug() << "Finished counting dir: " << dirName;
 }
 
-void CMainWindow::slotAddFilesFound( int numFiles )
+void CMainWindow::slotNumFilesFinishedComputing( int numFiles )
 {
     if ( !fProgress )
         return;
+    fTotalFiles = numFiles;
     fProgress->setComputeRange( 0, numFiles );
     fProgress->setFindRange( 0, numFiles );
     fProgress->setMD5Range( 0, numFiles );
-}
 
-void CMainWindow::slotNumFilesFinishedComputing( int numFiles )
-{
-    if ( !fProgress )
-        return;
-    fTotalFiles = numFiles;
-    slotAddFilesFound( numFiles );
-
-    fFileFinder->reset();
-    fFileFinder->setRootDir( fImpl->dirName->currentText() );
-    fFileFinder->setIgnoredPathNames( getIgnoredPathNames() );
-    fFileFinder->setIgnoreHidden( fImpl->ignoreHidden->isChecked() );
-    fFileFinder->setIgnoreFilesOver( fImpl->ignoreFilesOver->isChecked(), fImpl->ignoreFilesOverValue->value() );
-    fFileFinder->setCaseInsensitiveNameCompare( fImpl->caseInsensitiveNameCompare->isChecked() );
+    configureFinder( fFileFinder );
+    fFileFinder->setProgress( fScanProgress );
+    fFileFinder->setChunkIndex( fChunkIndex );
+    fFileFinder->setImageIndex( fImageIndex );
 
     threadPool()->start( fFileFinder );
     QTimer::singleShot( 0, this, &CMainWindow::slotWaitForAllThreadsFinished );
 }
 
+void CMainWindow::configureFinder( CFileFinder *finder )
+{
+    finder->reset();
+    finder->setRootDir( fImpl->dirName->currentText() );
+    finder->setIgnoredPathNames( getIgnoredPathNames() );
+    finder->setIgnoreHidden( fImpl->ignoreHidden->isChecked() );
+    finder->setIgnoreFilesOver( fImpl->ignoreFilesOver->isChecked(), fImpl->ignoreFilesOverValue->value() );
+    finder->setHashLargeFilesOver( fImpl->hashLargeFilesOver->isChecked(), fImpl->hashLargeFilesOverValue->value(), ( fImpl->largeFileMode->currentIndex() == 1 ) ? EHashMode::eContentDefined : EHashMode::eTree );
+    finder->setFilter( fScanFilter );
+    finder->setSnapshot( fSnapshot );
+    finder->setSmallFilesUnder( fImpl->smallFilesUnder->value() );
+    finder->setNameMatcher( fNameMatcher );
+}
+
 void CMainWindow::slotWaitForAllThreadsFinished()
 {
     if ( !isFinished() )
@@ -860,54 +575,75 @@ bool CMainWindow::isFinished()
         threadPool()->waitForDone( 100 );
         return false;
     }
+    if ( !hashPipeline()->isIdle() )
+        return false;
+    if ( fImageIndex && !fImageIndex->isIdle() )
+        return false;
     fCheckForFinished.value().first++;
     return false;
 }
 
 void CMainWindow::slotGo()
 {
-    initModel();
-    fMap.clear();
+    QString errorMsg;
+    if ( !fScanFilter.setFilter( fImpl->scanFilter->text(), fImpl->dirName->currentText(), &errorMsg ) )
+    {
+        QMessageBox::critical( this, tr( "Invalid Filter" ), errorMsg );
+        return;
+    }
+
+    fDirWatcher->clear();
+    fNumLoadedFiles.reset();
+    fSnapshot = std::make_shared< CScanSnapshot >( fImpl->dirName->currentText() );
+    if ( fSnapshot->load() )
+    {
+        bool reuse = fImpl->incrementalRescan->isChecked();
+        if ( !fSnapshot->isComplete() && !reuse )
+            reuse = QMessageBox::question( this, tr( "Resume Scan?" ), tr( "The last scan of '%1' did not finish.<br>Resume it, reusing the files already processed?" ).arg( fImpl->dirName->currentText() ) ) == QMessageBox::StandardButton::Yes;
+        if ( !reuse )
+            fSnapshot = std::make_shared< CScanSnapshot >( fImpl->dirName->currentText() );
+    }
+    fSnapshot->setComplete( false );
+    fCheckpointTimer->start();
+
+    initModel( fImpl->dirName->currentText() );
     fDupesFound = { 0, 0 };
     fImpl->files->resizeColumnToContents( 0 );
     fImpl->files->setSortingEnabled( false );
-    fFilterModel->setLoadingValues( true );
+
+    fChunkIndex.reset();
+    if ( fImpl->hashLargeFilesOver->isChecked() )
+        fChunkIndex = std::make_shared< CChunkIndex >( hashPipeline()->bufferSize() );
+    fImageIndex.reset();
+    if ( fImpl->findSimilarImages->isChecked() )
+        fImageIndex = std::make_shared< CImageIndex >();
+    fNameMatcher.reset();
+    if ( fImpl->caseInsensitiveNameCompare->isChecked() )
+        fNameMatcher = std::make_shared< CNameMatcher >( static_cast< CNameMatcher::EKey >( fImpl->nameMatchKey->currentIndex() ), fImpl->nameMatchIgnoreCopies->isChecked() );
 
     auto computer = new CComputeNumFiles( this );
+    fScanProgress = std::make_shared< CScanProgress >();
     fProgress = new CProgressDlg( tr( "Cancel" ), nullptr );
+    fProgress->setScanProgress( fScanProgress );
+    fConcurrency->start( fScanProgress );
 
-    connect( computer, &CComputeNumFiles::sigFilesFound, this, &CMainWindow::slotAddFilesFound );
     connect( computer, &CComputeNumFiles::sigNumFilesFinished, this, &CMainWindow::slotNumFilesFinishedComputing );
     connect( computer, &CComputeNumFiles::sigFinished, fProgress, &CProgressDlg::slotFinishedComputingFileCount );
-    connect( computer, &CFileFinder::sigCurrentFindInfo, fProgress, &CProgressDlg::slotCurrentComputeInfo );
 
     connect( fProgress, &CProgressDlg::sigCanceled, computer, &CComputeNumFiles::slotStop );
     connect( fProgress, &CProgressDlg::sigCanceled, fFileFinder, &CFileFinder::slotStop );
 
-    connect( this, &CMainWindow::sigMD5FileStarted, fProgress, &CProgressDlg::slotMD5FileStarted );
-    connect( this, &CMainWindow::sigMD5ReadPositionStatus, fProgress, &CProgressDlg::slotMD5ReadPositionStatus );
-    connect( this, &CMainWindow::sigMD5FileFinishedReading, fProgress, &CProgressDlg::slotMD5FileFinishedReading );
-    connect( this, &CMainWindow::sigMD5FileFinishedComputing, fProgress, &CProgressDlg::slotMD5FileFinishedComputing );
-    connect( this, &CMainWindow::sigMD5FileFinished, fProgress, &CProgressDlg::slotMD5FileFinished );
-
     connect( fFileFinder, &CFileFinder::sigDirFinished, this, &CMainWindow::slotCountDirFinished );
     connect( fFileFinder, &CFileFinder::sigFinished, fProgress, &CProgressDlg::slotFindFinished );
-    connect( fFileFinder, &CFileFinder::sigCurrentFindInfo, fProgress, &CProgressDlg::slotCurrentFindInfo );
-    connect( fFileFinder, &CFileFinder::sigFilesFound, fProgress, &CProgressDlg::slotUpdateFilesFound );
 
-    computer->reset();
-    computer->setRootDir( fImpl->dirName->currentText() );
-    computer->setIgnoredPathNames( getIgnoredPathNames() );
-    computer->setIgnoreHidden( fImpl->ignoreHidden->isChecked() );
-    computer->setIgnoreFilesOver( fImpl->ignoreFilesOver->isChecked(), fImpl->ignoreFilesOverValue->value() );
-    computer->setCaseInsensitiveNameCompare( fImpl->caseInsensitiveNameCompare->isChecked() );
+    configureFinder( computer );
+    computer->setProgress( fScanProgress );
 
     fProgress->setComputeRange( 0, 0 );
     fProgress->setComputeValue( 0 );
 
     threadPool()->start( computer );
     fCheckForFinished = {};
-    fMD5FilesComputed = 0;
     fDupesFound = { 0, 0 };
     fTotalFiles = 0;
 
@@ -927,9 +663,24 @@ void CMainWindow::slotGo()
 
 void CMainWindow::slotFinished()
 {
+    if ( fNameMatcher )
+        loadNameMatches();
+
     fImpl->files->resizeColumnToContents( 0 );
     fImpl->files->setColumnWidth( 0, qMax( 100, fImpl->files->columnWidth( 0 ) ) );
 
+    fCheckpointTimer->stop();
+    fConcurrency->stop();
+    bool canceled = fProgress && fProgress->wasCanceled();
+    if ( fSnapshot )
+    {
+        fSnapshot->setComplete( !canceled );
+        fSnapshot->saveInBackground( !canceled );
+        fLastSnapshotSave = QDateTime::currentDateTime();
+    }
+    if ( !canceled && fImpl->watchForChanges->isChecked() )
+        startWatching();
+
     if ( fProgress )
     {
         fProgress->setMD5Finished();
@@ -937,12 +688,10 @@ void CMainWindow::slotFinished()
         fProgress->deleteLater();
     }
 
-    fFilterModel->setLoadingValues( false );
     fImpl->files->setSortingEnabled( true );
     fImpl->del->setEnabled( hasDuplicates() );
 
     updateResultsLabel();
-    showIcons();
 
     QLocale locale;
     QMessageBox::information(
@@ -954,50 +703,131 @@ void CMainWindow::slotFinished()
             .arg( locale.toString( fFileFinder->numFilesFound() ) )
             .arg( NSABUtils::NFileUtils::byteSizeString( fDupesFound.second ) )
             .arg( NSABUtils::secsToString( fStartTime.secsTo( fEndTime ) ) ) );
+
+    if ( canceled )
+    {
+        fChunkIndex.reset();
+        fImageIndex.reset();
+    }
+    else
+        showSimilarFiles();
 }
 
-void CMainWindow::showIcons()
+void CMainWindow::loadNameMatches()
 {
-    auto progress = std::make_unique< QProgressDialog >( tr( "Loading Icons..." ), tr( "Cancel" ), 0, 0 );
-    auto bar = new QProgressBar;
-    bar->setFormat( "%v of %m - %p%" );
-    progress->setBar( bar );
-    progress->setAutoReset( false );
-    progress->setAutoClose( false );
-    progress->setWindowModality( Qt::WindowModal );
-    progress->setMinimumDuration( 1 );
+    QApplication::setOverrideCursor( Qt::WaitCursor );
+    fModel->beginLoad();
+    fNameMatcher->group(
+        [ this ]( const SDigest &digest, const std::vector< SFileMeta > &files )
+        {
+            std::optional< size_t > group;
+            for ( auto &&ii : files )
+            {
+                if ( ii.fSize == 0 )
+                    continue;
+
+                group = fModel->addFile( digest, ii );
+                if ( group.has_value() && ( fModel->groupFileCount( group.value() ) > 1 ) )
+                {
+                    fDupesFound.first++;
+                    fDupesFound.second += ii.fSize;
+                }
+            }
+            if ( group.has_value() && ( fModel->groupFileCount( group.value() ) > 1 ) )
+                applyKeepPolicy( group.value() );
+        } );
+    fModel->endLoad();
+    QApplication::restoreOverrideCursor();
+}
 
-    auto rowCount = fFilterModel->rowCount();
-    progress->setRange( 0, rowCount );
-    for ( int ii = 0; ii < rowCount; ++ii )
+void CMainWindow::showSimilarFiles()
+{
+    if ( fImpl->findDuplicateDirs->isChecked() )
     {
-        auto item = itemFromFilterRow( ii );
-        progress->setValue( ii );
-        progress->setLabelText( tr( "Loading Icons..." ) );
-        showIcons( item );
-        if ( ( progress->value() % 50 ) == 0 )
+        QApplication::setOverrideCursor( Qt::WaitCursor );
+        CDuplicateDirs duplicateDirs( fModel );
+        duplicateDirs.find();
+        QApplication::restoreOverrideCursor();
+
+        if ( !duplicateDirs.groups().empty() || !duplicateDirs.subsets().empty() )
         {
-            progress->adjustSize();
+            CSimilarFilesDlg dlg( fModelRootDir, duplicateDirs, this );
+            dlg.exec();
+        }
+    }
+
+    auto chunkIndex = fChunkIndex;
+    fChunkIndex.reset();
+    if ( chunkIndex && ( chunkIndex->numFiles() > 1 ) )
+    {
+        QApplication::setOverrideCursor( Qt::WaitCursor );
+        QString errorMsg;
+        auto similarFiles = chunkIndex->similarFiles( fImpl->similarFilesPercent->value() / 100.0, &errorMsg );
+        QApplication::restoreOverrideCursor();
+
+        if ( !errorMsg.isEmpty() )
+            QMessageBox::critical( this, tr( "Could not Find Similar Files" ), errorMsg );
+        else if ( !similarFiles.empty() )
+        {
+            CSimilarFilesDlg dlg( fModelRootDir, similarFiles, this );
+            dlg.exec();
+        }
+    }
+
+    auto imageIndex = fImageIndex;
+    fImageIndex.reset();
+    if ( imageIndex && ( imageIndex->numImages() > 1 ) )
+    {
+        QApplication::setOverrideCursor( Qt::WaitCursor );
+        auto similarImages = imageIndex->similarImages( fImpl->similarImagesDistance->value() );
+        QApplication::restoreOverrideCursor();
+
+        if ( !similarImages.empty() )
+        {
+            CSimilarFilesDlg dlg( fModelRootDir, similarImages, this );
+            dlg.exec();
         }
-        if ( progress->wasCanceled() )
-            break;
     }
 }
 
-void CMainWindow::showIcons( QStandardItem *item )
+void CMainWindow::slotCheckpoint()
 {
-    if ( !item->parent() && ( item->rowCount() <= 1 ) )
+    // directories already enumerated and files already hashed are in the snapshot,
+    // a resumed scan reuses them and only reads what was not done before the checkpoint
+    if ( fSnapshot && fProgress )
+    {
+        fSnapshot->saveInBackground( false );
+        fLastSnapshotSave = QDateTime::currentDateTime();
+    }
+}
+
+void CMainWindow::slotWatchForChanges()
+{
+    if ( !fImpl->watchForChanges->isChecked() )
+        fDirWatcher->stop();
+    else if ( fSnapshot && !fProgress )   // only once a scan has completed
+        startWatching();
+}
+
+void CMainWindow::startWatching()
+{
+    if ( fDirWatcher->isWatching() )
         return;
 
-    auto relToDir = QDir( fImpl->dirName->currentText() );
-    auto path = relToDir.absoluteFilePath( item->text() );
+    configureFinder( fWatchFinder );
+    fDirWatcher->start();
+}
+
+void CMainWindow::slotRescanFinished()
+{
+    fImpl->del->setEnabled( hasDuplicates() );
+    updateResultsLabel();
 
-    auto icon = QIcon( path );
-    item->setIcon( icon );
-    for ( int ii = 0; ii < item->rowCount(); ++ii )
+    // the snapshot holds the digests of the new files, save it every so often so a restart does not lose them
+    if ( fSnapshot && ( !fLastSnapshotSave.isValid() || ( fLastSnapshotSave.secsTo( QDateTime::currentDateTime() ) > 60 ) ) )
     {
-        auto child = item->child( ii, 0 );
-        showIcons( child );
+        fSnapshot->saveInBackground( false );
+        fLastSnapshotSave = QDateTime::currentDateTime();
     }
 }
 
@@ -1005,18 +835,19 @@ void CMainWindow::updateResultsLabel()
 {
     QLocale locale;
 
+    auto numFiles = fNumLoadedFiles.has_value() ? fNumLoadedFiles.value() : static_cast< quint64 >( fFileFinder->numFilesFound() );
     QString text;
     if ( fDupesFound.first == 0 )
         text = tr( "Results:" );
     else
-        text = tr( "Results: Number of Duplicates %1 of %2 files processed, Total size of Duplicates: %3" ).arg( locale.toString( fDupesFound.first ) ).arg( locale.toString( fFileFinder->numFilesFound() ) ).arg( NSABUtils::NFileUtils::byteSizeString( fDupesFound.second ) );
+        text = tr( "Results: Number of Duplicates %1 of %2 files processed, Total size of Duplicates: %3" ).arg( locale.toString( fDupesFound.first ) ).arg( locale.toString( numFiles ) ).arg( NSABUtils::NFileUtils::byteSizeString( fDupesFound.second ) );
 
     fImpl->resultsLabel->setText( text );
 }
 
 void CMainWindow::slotAddIgnoredPathName()
 {
-    auto fn = QInputDialog::getText( this, tr( "Pathname to Ignore" ), tr( "Path Name (Regular Expression):" ) );
+    auto fn = QInputDialog::getText( this, tr( "Pathname to Ignore" ), tr( "Path Name (Regular Expression, end with / to match directories only, include a / to match the path relative to the search directory):" ) );
     if ( fn.isEmpty() )
         return;
 
@@ -1031,3 +862,104 @@ void CMainWindow::slotDelIgnoredPathName()
 
     delete curr;
 }
+
+void CMainWindow::slotSaveResults()
+{
+    if ( fProgress || ( fModel->numGroups() == 0 ) )
+    {
+        QMessageBox::information( this, tr( "No Results" ), tr( "There are no finished results to save." ) );
+        return;
+    }
+
+    QSettings settings;
+    auto fileName = QFileDialog::getSaveFileName( this, tr( "Save Results" ), settings.value( "ResultsFile" ).toString(), tr( "Results Files (*.fdr);;All Files (*.*)" ) );
+    if ( fileName.isEmpty() )
+        return;
+    settings.setValue( "ResultsFile", fileName );
+
+    auto rootDir = QDir( fModelRootDir );
+    std::vector< CResultsFile::SGroup > groups;
+    groups.reserve( fModel->numGroups() );
+    for ( size_t ii = 0; ii < fModel->numGroups(); ++ii )
+    {
+        auto &&files = fModel->groupFiles( ii );
+        if ( files.empty() )
+            continue;
+
+        CResultsFile::SGroup group;
+        group.fDigest = fModel->groupDigest( ii );
+        group.fFiles.reserve( files.size() );
+        for ( auto &&jj : files )
+        {
+            CResultsFile::SFile file;
+            file.fMeta = fModel->fileMeta( jj );
+            file.fMeta.fPath = rootDir.relativeFilePath( file.fMeta.fPath );
+            file.fDelete = jj.fDelete;
+            group.fFiles.push_back( file );
+        }
+        groups.push_back( group );
+    }
+
+    QString errorMsg;
+    if ( !CResultsFile::save( fileName, fModelRootDir, groups, &errorMsg ) )
+        QMessageBox::critical( this, tr( "Could not Save Results" ), errorMsg );
+}
+
+void CMainWindow::slotLoadResults()
+{
+    if ( fProgress )
+        return;
+
+    QSettings settings;
+    auto fileName = QFileDialog::getOpenFileName( this, tr( "Open Results" ), settings.value( "ResultsFile" ).toString(), tr( "Results Files (*.fdr);;All Files (*.*)" ) );
+    if ( fileName.isEmpty() )
+        return;
+    settings.setValue( "ResultsFile", fileName );
+
+    CResultsFile results( fileName );
+    QString errorMsg;
+    if ( !results.open( &errorMsg ) )
+    {
+        QMessageBox::critical( this, tr( "Could not Open Results" ), errorMsg );
+        return;
+    }
+
+    fDirWatcher->clear();
+    fSnapshot.reset();
+    fNameMatcher.reset();
+
+    initModel( results.rootDir() );
+    fImpl->dirName->setCurrentText( fModelRootDir );
+    fDupesFound = { 0, 0 };
+    fNumLoadedFiles = results.numFiles();
+
+    // every file is decoded and added to the model, the view's rows are created as they are fetched
+    auto rootDir = QDir( fModelRootDir );
+    fModel->beginLoad();
+    for ( quint64 ii = 0; ii < results.numGroups(); ++ii )
+    {
+        auto digest = results.groupDigest( ii );
+        auto numFiles = results.groupFileCount( ii );
+        for ( quint32 jj = 0; jj < numFiles; ++jj )
+        {
+            auto file = results.file( ii, jj );
+            if ( file.fMeta.fSize == 0 )
+                continue;
+
+            file.fMeta.fPath = rootDir.absoluteFilePath( file.fMeta.fPath );
+            auto group = fModel->addFile( digest, file.fMeta, file.fDelete );
+            if ( group.has_value() && ( fModel->groupFileCount( group.value() ) > 1 ) )
+            {
+                fDupesFound.first++;
+                fDupesFound.second += file.fMeta.fSize;
+            }
+        }
+    }
+    fModel->endLoad();
+    fImpl->files->sortByColumn( fImpl->files->header()->sortIndicatorSection(), fImpl->files->header()->sortIndicatorOrder() );
+
+    fImpl->files->resizeColumnToContents( 0 );
+    fImpl->files->setColumnWidth( 0, qMax( 100, fImpl->files->columnWidth( 0 ) ) );
+    fImpl->del->setEnabled( hasDuplicates() );
+    updateResultsLabel();
+}
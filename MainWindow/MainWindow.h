@@ -13,19 +13,29 @@
 #include <unordered_set>
 
 #include "SABUtils/HashUtils.h"
+#include "KeepPolicy.h"
+#include "Digest.h"
+#include "ScanFilter.h"
+#include "FileFinder.h"
 
 class CProgressDlg;
-class QStandardItem;
-class CFilterModel;
-class QStandardItemModel;
+class CDupeModel;
 class QFileInfo;
 class QThreadPool;
+class QTimer;
 namespace Ui
 {
     class CMainWindow;
 }
 
-class CFileFinder;
+class CScanSnapshot;
+class CChunkIndex;
+class CImageIndex;
+class CNameMatcher;
+class CDirWatcher;
+class CScanProgress;
+class CHashPipeline;
+class CConcurrencyController;
 
 class CMainWindow : public QMainWindow
 {
@@ -35,12 +45,9 @@ public:
     ~CMainWindow();
 
     static QThreadPool *threadPool();
+    static CHashPipeline *hashPipeline();
 Q_SIGNALS:
-    void sigMD5FileStarted( unsigned long long threadID, const QDateTime &dt, const QString &filename );
-    void sigMD5ReadPositionStatus( unsigned long long threadID, const QDateTime &dt, const QString &filename, qint64 pos );
-    void sigMD5FileFinishedReading( unsigned long long threadID, const QDateTime &dt, const QString &filename );
-    void sigMD5FileFinishedComputing( unsigned long long threadID, const QDateTime &dt, const QString &filename );
-    void sigMD5FileFinished( unsigned long long threadID, const QDateTime &dt, const QString &filename, const QString &md5 );
+    void sigMD5FileFinished( unsigned long long threadID, const QDateTime &dt, const SHashedFile &file );
 
 public Q_SLOTS:
     void slotGo();
@@ -54,10 +61,10 @@ public Q_SLOTS:
     void slotShowDupesOnly();
     void slotNumFilesFinishedComputing( int numFiles );
 
-    void slotAddFilesFound( int numFiles );
     void slotFileDoubleClicked( const QModelIndex &idx );
     void slotFileContextMenu( const QPoint &pos );
-    void slotMD5FileFinished( unsigned long long threadID, const QDateTime &endTime, const QString &fileName, const QString &md5 );
+    void slotMD5FileFinished( unsigned long long threadID, const QDateTime &endTime, const SHashedFile &file );
+    void slotSmallFilesFinished( const THashedFiles &files );
 
     void slotCountDirFinished( const QString &dirName );
     void slotFindDirFinished( const QString &dirName );
@@ -66,14 +73,25 @@ public Q_SLOTS:
     void slotDelIgnoredPathName();
 
     void slotIgnoreFilesOver();
+    void slotHashLargeFilesOver();
+    void slotKeepPolicyChanged();
+    void slotWatchForChanges();
+    void slotRescanFinished();
+    void slotFileRemoved( const QString &fileName );
+    void slotDirRemoved( const QString &dirName );
     void slotWaitForAllThreadsFinished();
 
+    void slotCheckpoint();
+
+    void slotSaveResults();
+    void slotLoadResults();
+
 private:
     bool isFinished();
-
-    QList< QStandardItem * > createFileRow( const QFileInfo &fi, const QString &md5 );
-    bool hasChildFile( QStandardItem *header, const QFileInfo &fi ) const;
-    QFileInfo getFileInfo( QStandardItem *item ) const;
+    void configureFinder( CFileFinder *finder );
+    void startWatching();
+    void loadNameMatches();
+    void showSimilarFiles();
 
     void updateResultsLabel();
 
@@ -81,36 +99,32 @@ private:
     void addIgnoredPathName( const QString &ignoredPathName );
     void addIgnoredPathNames( QStringList ignoredPathNames );
 
-    int fileCount( int row ) const;
-    int fileCount( QStandardItem *item ) const;
-    void setFileCount( int row, int count );
-    void setFileCount( QStandardItem *item, int count );
-
     bool hasDuplicates() const;
-    QStringList filesToDelete( int ii );
-    QStringList filesToDelete( QStandardItem *item );
-
-    QStandardItem * itemFromFilterRow( int ii );
-
-    bool deleteFile( QStandardItem *item ) const;
-    void determineFilesToDeleteRoot( QStandardItem *item );
-    QList< QStandardItem * > determineFilesToDelete( QStandardItem *rootFileFN );
-    void setDeleteFile( QStandardItem *item, bool deleteFile, bool handleChildren );
-    QList< QStandardItem * > getAllFiles( QStandardItem *rootFileFN ) const;
-    void showIcons();
-    void showIcons( QStandardItem *item );
+    bool addHashedFile( const SDigest &digest, const SFileMeta &meta );   // true when the file is a duplicate
+    void applyKeepPolicy( size_t group );
     void deleteFiles( const QStringList &filesToDelete );
 
-    void initModel();
+    void initModel( const QString &rootDir );
     QPointer< CProgressDlg > fProgress;
-    QStandardItemModel *fModel;
-    CFilterModel *fFilterModel;
+    CDupeModel *fModel{ nullptr };
     std::unique_ptr< Ui::CMainWindow > fImpl;
-    std::unordered_map< QString, std::pair< QStandardItem *, QStandardItem * > > fMap;
+    QString fModelRootDir;   // the directory the current results are relative to
 
     CFileFinder *fFileFinder{ nullptr };
+    CFileFinder *fWatchFinder{ nullptr };
+    CDirWatcher *fDirWatcher{ nullptr };
+    QDateTime fLastSnapshotSave;
+    QTimer *fCheckpointTimer{ nullptr };
+    CConcurrencyController *fConcurrency{ nullptr };
+    CKeepPolicy fKeepPolicy;
+    CScanFilter fScanFilter;
+    std::shared_ptr< CScanSnapshot > fSnapshot;
+    std::shared_ptr< CChunkIndex > fChunkIndex;   // only when content defined chunking large files
+    std::shared_ptr< CImageIndex > fImageIndex;   // only when finding similar images
+    std::shared_ptr< CNameMatcher > fNameMatcher;   // only when matching by name, kept for rescans
+    std::shared_ptr< CScanProgress > fScanProgress;
     std::pair< int, uint64_t > fDupesFound{ 0, 0 };   // number of dupes, size of dupes
-    int fMD5FilesComputed{ 0 };
+    std::optional< quint64 > fNumLoadedFiles;   // set while the results come from a results file rather than a scan
 
     int fTotalFiles{ 0 };
     std::optional< std::pair< int, QDateTime > > fCheckForFinished;   // 5 times with over a 500 ms second delay.
@@ -0,0 +1,98 @@
+#include "NameMatcher.h"
+#include "DirEntry.h"
+
+#include <cstring>
+
+CNameMatcher::CNameMatcher( EKey key, bool ignoreCopySuffixes ) :
+    fKey( key ),
+    fIgnoreCopySuffixes( ignoreCopySuffixes )
+{
+}
+
+void CNameMatcher::addFile( const QString &fileName, const SDirEntry &entry )
+{
+    QMutexLocker locker( &fMutex );
+    fFiles.push_back( { fileName, entry.fSize, entry.fMTime, entry.fCTime } );
+}
+
+size_t CNameMatcher::numFiles() const
+{
+    QMutexLocker locker( &fMutex );
+    return fFiles.size();
+}
+
+CNameMatcher::SKey CNameMatcher::key( const QString &fileName, qint64 size, qint64 mTime ) const
+{
+    SKey retVal;
+    retVal.fName = fileName.mid( fileName.lastIndexOf( '/' ) + 1 );
+
+    QString baseName;
+    if ( fIgnoreCopySuffixes && CKeepPolicy::isCopyName( retVal.fName, &baseName ) )
+    {
+        auto dotPos = retVal.fName.lastIndexOf( '.' );
+        retVal.fName = ( dotPos > 0 ) ? baseName + retVal.fName.mid( dotPos ) : baseName;
+    }
+    retVal.fName = retVal.fName.toLower();
+
+    if ( fKey != EKey::eName )
+        retVal.fSize = size;
+    if ( fKey == EKey::eNameSizeMTime )
+        retVal.fMTime = mTime;
+    return retVal;
+}
+
+quint32 CNameMatcher::groupNumber( SKey &&key )
+{
+    auto groupNumber = static_cast< quint32 >( fGroups.size() );
+    return fGroups.emplace( std::move( key ), groupNumber ).first->second;
+}
+
+SDigest CNameMatcher::groupDigest( quint32 groupNumber )
+{
+    SDigest retVal;
+    std::memcpy( retVal.fBytes.data(), &groupNumber, sizeof( groupNumber ) );
+    return retVal;
+}
+
+void CNameMatcher::group( const TVisitor &visitor )
+{
+    QMutexLocker locker( &fMutex );
+
+    std::vector< quint32 > groupNumbers;
+    groupNumbers.reserve( fFiles.size() );
+    for ( auto &&ii : fFiles )
+        groupNumbers.push_back( groupNumber( key( ii.fPath, ii.fSize, ii.fMTime ) ) );
+
+    // counting sort of the files by group number, group numbers are handed out in the order the groups are first seen
+    std::vector< size_t > groupStart( fGroups.size() + 1, 0 );
+    for ( auto &&ii : groupNumbers )
+        groupStart[ ii + 1 ]++;
+    for ( size_t ii = 1; ii < groupStart.size(); ++ii )
+        groupStart[ ii ] += groupStart[ ii - 1 ];
+
+    std::vector< size_t > order( fFiles.size() );
+    auto next = groupStart;
+    for ( size_t ii = 0; ii < groupNumbers.size(); ++ii )
+        order[ next[ groupNumbers[ ii ] ]++ ] = ii;
+
+    std::vector< SFileMeta > files;
+    for ( size_t ii = 0; ( ii + 1 ) < groupStart.size(); ++ii )
+    {
+        if ( groupStart[ ii ] == groupStart[ ii + 1 ] )
+            continue;
+
+        files.clear();
+        for ( auto jj = groupStart[ ii ]; jj < groupStart[ ii + 1 ]; ++jj )
+            files.push_back( std::move( fFiles[ order[ jj ] ] ) );
+        visitor( groupDigest( static_cast< quint32 >( ii ) ), files );
+    }
+
+    fFiles.clear();
+    fFiles.shrink_to_fit();
+}
+
+SDigest CNameMatcher::digest( const QString &fileName, const SDirEntry &entry )
+{
+    QMutexLocker locker( &fMutex );
+    return groupDigest( groupNumber( key( fileName, entry.fSize, entry.fMTime ) ) );
+}
@@ -0,0 +1,69 @@
+#ifndef NAMEMATCHER_H
+#define NAMEMATCHER_H
+
+#include "Digest.h"
+#include "KeepPolicy.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+struct SDirEntry;
+
+// Name based duplicate matching, nothing is read or hashed
+// The walk only records the files it finds, the groups are formed afterwards in one pass over the records
+// through a hash map keyed on the case insensitive name, optionally with copy suffixes such as "(1)" and
+// " - Copy" removed, and the size and modification time
+// Each group is identified by a synthetic digest holding its number, so the results model and saved results are unchanged
+class CNameMatcher
+{
+public:
+    enum class EKey
+    {
+        eName,
+        eNameSize,
+        eNameSizeMTime
+    };
+
+    CNameMatcher( EKey key, bool ignoreCopySuffixes );
+
+    void addFile( const QString &fileName, const SDirEntry &entry );   // recorded for group()
+    size_t numFiles() const;
+
+    // called once per group with the files recorded since the last call, in the order the groups were first seen
+    using TVisitor = std::function< void( const SDigest &digest, const std::vector< SFileMeta > &files ) >;
+    void group( const TVisitor &visitor );
+
+    // the group of a file found after grouping, a new group when no file with its key was seen
+    SDigest digest( const QString &fileName, const SDirEntry &entry );
+
+private:
+    struct SKey
+    {
+        QString fName;
+        qint64 fSize{ 0 };
+        qint64 fMTime{ 0 };
+
+        bool operator==( const SKey &rhs ) const { return ( fSize == rhs.fSize ) && ( fMTime == rhs.fMTime ) && ( fName == rhs.fName ); }
+    };
+    struct SKeyHash
+    {
+        size_t operator()( const SKey &key ) const { return qHash( key.fMTime, qHash( key.fSize, qHash( key.fName ) ) ); }
+    };
+
+    SKey key( const QString &fileName, qint64 size, qint64 mTime ) const;
+    quint32 groupNumber( SKey &&key );
+    static SDigest groupDigest( quint32 groupNumber );
+
+    EKey fKey;
+    bool fIgnoreCopySuffixes;
+
+    mutable QMutex fMutex;
+    std::vector< SFileMeta > fFiles;
+    std::unordered_map< SKey, quint32, SKeyHash > fGroups;
+};
+
+#endif
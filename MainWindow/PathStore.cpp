@@ -0,0 +1,234 @@
+#include "PathStore.h"
+
+#include <QHash>
+#include <algorithm>
+
+constexpr size_t sMinTableSize = 64;   // a power of two
+
+CPathStore::CPathStore()
+{
+}
+
+void CPathStore::clear()
+{
+    fNames.clear();
+    fDirs.clear();
+    fFiles.clear();
+    fDirTable = {};
+    fFileTable = {};
+    fFirstSubDir.clear();
+    fNextSubDir.clear();
+    fFirstFile.clear();
+    fNextFile.clear();
+}
+
+size_t CPathStore::hash( TID parent, const QChar *name, int length )
+{
+    return qHashBits( name, length * sizeof( QChar ), parent );
+}
+
+bool CPathStore::nameEquals( const SNode &node, const QChar *name, int length ) const
+{
+    if ( static_cast< int >( node.fNameLength ) != length )
+        return false;
+    return std::equal( name, name + length, fNames.begin() + node.fNameOffset );
+}
+
+std::optional< CPathStore::TID > CPathStore::find( const STable &table, const std::vector< SNode > &nodes, TID parent, const QChar *name, int length ) const
+{
+    if ( table.fSlots.empty() )
+        return {};
+
+    auto mask = table.fSlots.size() - 1;
+    for ( auto slot = hash( parent, name, length ) & mask; table.fSlots[ slot ] != sInvalid; slot = ( slot + 1 ) & mask )
+    {
+        auto &&node = nodes[ table.fSlots[ slot ] ];
+        if ( ( node.fParent == parent ) && nameEquals( node, name, length ) )
+            return table.fSlots[ slot ];
+    }
+    return {};
+}
+
+void CPathStore::grow( STable &table, const std::vector< SNode > &nodes )
+{
+    auto size = std::max( sMinTableSize, table.fSlots.size() * 2 );
+    table.fSlots.assign( size, sInvalid );
+    auto mask = size - 1;
+    for ( TID ii = 0; ii < nodes.size(); ++ii )
+    {
+        auto &&node = nodes[ ii ];
+        auto slot = hash( node.fParent, fNames.data() + node.fNameOffset, node.fNameLength ) & mask;
+        while ( table.fSlots[ slot ] != sInvalid )
+            slot = ( slot + 1 ) & mask;
+        table.fSlots[ slot ] = ii;
+    }
+}
+
+CPathStore::TID CPathStore::insert( STable &table, std::vector< SNode > &nodes, TID parent, const QChar *name, int length )
+{
+    auto existing = find( table, nodes, parent, name, length );
+    if ( existing.has_value() )
+        return existing.value();
+
+    // kept at most 3/4 full so probes stay short
+    if ( ( table.fUsed + 1 ) * 4 > table.fSlots.size() * 3 )
+        grow( table, nodes );
+
+    auto id = static_cast< TID >( nodes.size() );
+    nodes.push_back( { parent, static_cast< quint32 >( fNames.size() ), static_cast< quint32 >( length ) } );
+    fNames.insert( fNames.end(), name, name + length );
+
+    auto mask = table.fSlots.size() - 1;
+    auto slot = hash( parent, name, length ) & mask;
+    while ( table.fSlots[ slot ] != sInvalid )
+        slot = ( slot + 1 ) & mask;
+    table.fSlots[ slot ] = id;
+    table.fUsed++;
+    return id;
+}
+
+CPathStore::TID CPathStore::addFile( const QString &path )
+{
+    auto data = path.constData();
+    auto sep = path.lastIndexOf( '/' );
+
+    TID dir = sInvalid;
+    for ( int start = 0; ( sep >= 0 ) && ( start <= sep ); )
+    {
+        auto end = path.indexOf( '/', start );
+        auto numDirs = fDirs.size();
+        dir = insert( fDirTable, fDirs, dir, data + start, end - start );
+        if ( fDirs.size() != numDirs )
+            linkDir( dir );
+        start = end + 1;
+    }
+    auto numFiles = fFiles.size();
+    auto retVal = insert( fFileTable, fFiles, dir, data + sep + 1, path.length() - sep - 1 );
+    if ( fFiles.size() != numFiles )
+        linkFile( retVal );
+    return retVal;
+}
+
+void CPathStore::linkDir( TID dir )
+{
+    auto parent = fDirs[ dir ].fParent;
+    fFirstSubDir.push_back( sInvalid );
+    fFirstFile.push_back( sInvalid );
+    fNextSubDir.push_back( ( parent == sInvalid ) ? sInvalid : fFirstSubDir[ parent ] );
+    if ( parent != sInvalid )
+        fFirstSubDir[ parent ] = dir;
+}
+
+void CPathStore::linkFile( TID file )
+{
+    auto parent = fFiles[ file ].fParent;
+    fNextFile.push_back( ( parent == sInvalid ) ? sInvalid : fFirstFile[ parent ] );
+    if ( parent != sInvalid )
+        fFirstFile[ parent ] = file;
+}
+
+std::optional< CPathStore::TID > CPathStore::findDir( const QString &path ) const
+{
+    auto data = path.constData();
+    TID dir = sInvalid;
+    for ( int start = 0; start <= path.length(); )
+    {
+        auto end = path.indexOf( '/', start );
+        if ( end < 0 )
+            end = path.length();
+        auto found = find( fDirTable, fDirs, dir, data + start, end - start );
+        if ( !found.has_value() )
+            return {};
+        dir = found.value();
+        start = end + 1;
+    }
+    return dir;
+}
+
+std::optional< CPathStore::TID > CPathStore::findFile( const QString &path ) const
+{
+    auto sep = path.lastIndexOf( '/' );
+    TID dir = sInvalid;
+    if ( sep >= 0 )
+    {
+        auto found = findDir( path.left( sep ) );
+        if ( !found.has_value() )
+            return {};
+        dir = found.value();
+    }
+    return find( fFileTable, fFiles, dir, path.constData() + sep + 1, path.length() - sep - 1 );
+}
+
+void CPathStore::appendPath( QString &retVal, TID dir ) const
+{
+    if ( dir == sInvalid )
+        return;
+
+    std::vector< TID > chain;
+    for ( ; dir != sInvalid; dir = fDirs[ dir ].fParent )
+        chain.push_back( dir );
+
+    for ( auto ii = chain.rbegin(); ii != chain.rend(); ++ii )
+    {
+        if ( ii != chain.rbegin() )
+            retVal += '/';
+        auto &&node = fDirs[ *ii ];
+        retVal.append( fNames.data() + node.fNameOffset, node.fNameLength );
+    }
+}
+
+QString CPathStore::dirPath( TID dir ) const
+{
+    QString retVal;
+    appendPath( retVal, dir );
+    return retVal;
+}
+
+QString CPathStore::dirName( TID dir ) const
+{
+    auto &&node = fDirs[ dir ];
+    return QString( fNames.data() + node.fNameOffset, node.fNameLength );
+}
+
+QString CPathStore::fileName( TID file ) const
+{
+    auto &&node = fFiles[ file ];
+    return QString( fNames.data() + node.fNameOffset, node.fNameLength );
+}
+
+QString CPathStore::path( TID file ) const
+{
+    auto &&node = fFiles[ file ];
+    QString retVal;
+    appendPath( retVal, node.fParent );
+    if ( node.fParent != sInvalid )
+        retVal += '/';
+    retVal.append( fNames.data() + node.fNameOffset, node.fNameLength );
+    return retVal;
+}
+
+bool CPathStore::isUnder( TID file, TID dir ) const
+{
+    for ( auto ii = fFiles[ file ].fParent; ii != sInvalid; ii = fDirs[ ii ].fParent )
+    {
+        if ( ii == dir )
+            return true;
+    }
+    return false;
+}
+
+std::vector< CPathStore::TID > CPathStore::filesUnder( TID dir ) const
+{
+    std::vector< TID > retVal;
+    std::vector< TID > dirs( 1, dir );
+    while ( !dirs.empty() )
+    {
+        auto curr = dirs.back();
+        dirs.pop_back();
+        for ( auto ii = fFirstFile[ curr ]; ii != sInvalid; ii = fNextFile[ ii ] )
+            retVal.push_back( ii );
+        for ( auto ii = fFirstSubDir[ curr ]; ii != sInvalid; ii = fNextSubDir[ ii ] )
+            dirs.push_back( ii );
+    }
+    return retVal;
+}
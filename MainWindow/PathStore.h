@@ -0,0 +1,72 @@
+#ifndef PATHSTORE_H
+#define PATHSTORE_H
+
+#include <QString>
+#include <optional>
+#include <vector>
+
+// Interned paths, every directory is stored once as (parent directory, name) and every file as (directory, name)
+// The names live in one character arena and the nodes are looked up through open addressed tables of ids,
+// so a file costs its name plus a few dozen bytes and paths are compared by comparing ids
+// Each directory also links its subdirectories and files, so the files under a directory are found without a scan of every file
+// Not thread safe
+class CPathStore
+{
+public:
+    using TID = quint32;
+    static constexpr TID sInvalid = ~TID( 0 );
+
+    CPathStore();
+
+    void clear();
+
+    TID addFile( const QString &path );   // an existing file keeps its id
+    std::optional< TID > findFile( const QString &path ) const;
+    std::optional< TID > findDir( const QString &path ) const;
+
+    size_t numFiles() const { return fFiles.size(); }
+    QString path( TID file ) const;
+    QString fileName( TID file ) const;
+    TID dirOf( TID file ) const { return fFiles[ file ].fParent; }
+    QString dirPath( TID dir ) const;
+    QString dirName( TID dir ) const;
+    size_t numDirs() const { return fDirs.size(); }   // a directory's id is always above its parent's
+    TID parentOf( TID dir ) const { return fDirs[ dir ].fParent; }
+    bool isUnder( TID file, TID dir ) const;   // in the directory or any directory below it
+    std::vector< TID > filesUnder( TID dir ) const;   // every file in the directory or any directory below it
+
+private:
+    struct SNode
+    {
+        TID fParent{ sInvalid };
+        quint32 fNameOffset{ 0 };
+        quint32 fNameLength{ 0 };
+    };
+    struct STable
+    {
+        std::vector< TID > fSlots;
+        size_t fUsed{ 0 };
+    };
+
+    static size_t hash( TID parent, const QChar *name, int length );
+    bool nameEquals( const SNode &node, const QChar *name, int length ) const;
+    std::optional< TID > find( const STable &table, const std::vector< SNode > &nodes, TID parent, const QChar *name, int length ) const;
+    TID insert( STable &table, std::vector< SNode > &nodes, TID parent, const QChar *name, int length );
+    void grow( STable &table, const std::vector< SNode > &nodes );
+    void appendPath( QString &retVal, TID dir ) const;
+    void linkDir( TID dir );
+    void linkFile( TID file );
+
+    std::vector< QChar > fNames;
+    std::vector< SNode > fDirs;
+    std::vector< SNode > fFiles;
+    STable fDirTable;
+    STable fFileTable;
+
+    std::vector< TID > fFirstSubDir;   // by directory, the rest are linked through fNextSubDir
+    std::vector< TID > fNextSubDir;   // by directory, the next one with the same parent
+    std::vector< TID > fFirstFile;   // by directory, the rest are linked through fNextFile
+    std::vector< TID > fNextFile;   // by file, the next one in the same directory
+};
+
+#endif
@@ -1,6 +1,8 @@
 #include "ProgressDlg.h"
 #include "MainWindow.h"
 #include "ui_ProgressDlg.h"
+#include "ScanProgress.h"
+#include "JobStatusModel.h"
 #include "SABUtils/utils.h"
 #include "SABUtils/FileUtils.h"
 #include "SABUtils/SystemInfo.h"
@@ -16,7 +18,12 @@
 #include <QPushButton>
 #include <QDateTime>
 #include <QTimer>
+#include <QHeaderView>
 #include <QSettings>
+#include <algorithm>
+
+constexpr int sUpdateInterval = 500;   // msecs
+constexpr double sRateSmoothing = 0.2;
 
 CProgressDlg::CProgressDlg( QWidget *parent ) :
     QWidget( parent ),
@@ -41,6 +48,15 @@ CProgressDlg::CProgressDlg( QWidget *parent ) :
 
     connect( fImpl->buttonBox, &QDialogButtonBox::rejected, this, &CProgressDlg::slotCanceled );
 
+    fJobModel = new CJobStatusModel( this );
+    fImpl->status->setModel( fJobModel );
+    fImpl->status->verticalHeader()->setSectionResizeMode( QHeaderView::Fixed );
+    fImpl->status->horizontalHeader()->setSectionResizeMode( QHeaderView::Interactive );
+
+    fUpdateTimer = new QTimer( this );
+    fUpdateTimer->setInterval( sUpdateInterval );
+    connect( fUpdateTimer, &QTimer::timeout, this, &CProgressDlg::slotUpdateStatusInfo );
+
     QSettings settings;
     auto sortBy = settings.value( "SortProgressBy", 0 ).toInt();
     switch ( sortBy )
@@ -78,6 +94,18 @@ CProgressDlg::~CProgressDlg()
     settings.setValue( "SortProgressBy", value );
 }
 
+void CProgressDlg::setScanProgress( std::shared_ptr< CScanProgress > scanProgress )
+{
+    fScanProgress = scanProgress;
+    fLastBytesHashed = 0;
+    fLastRateSample = QDateTime::currentMSecsSinceEpoch();
+    fBytesPerSec = 0.0;
+    if ( fScanProgress )
+        fUpdateTimer->start();
+    else
+        fUpdateTimer->stop();
+}
+
 void CProgressDlg::setCountingFiles( bool counting )
 {
     fImpl->computeGroup->setVisible( counting );
@@ -117,7 +145,6 @@ void CProgressDlg::slotFinishedComputingFileCount()
 void CProgressDlg::setComputeValue( int value )
 {
     fImpl->computeProgress->setValue( value );
-    slotUpdateStatusInfo();
 }
 
 void CProgressDlg::setComputeRange( int min, int max )
@@ -125,14 +152,9 @@ void CProgressDlg::setComputeRange( int min, int max )
     fImpl->computeProgress->setRange( min, max );
 }
 
-void CProgressDlg::setCurrentComputeInfo( const QFileInfo &fileInfo )
+void CProgressDlg::setCurrentComputeInfo( const QString &fileName, qint64 size )
 {
-    setCurrentInfo( fileInfo, fImpl->computeText );
-}
-
-void CProgressDlg::slotCurrentComputeInfo( const QString &fileName )
-{
-    setCurrentComputeInfo( QFileInfo( fileName ) );
+    setCurrentInfo( fileName, size, fImpl->computeText );
 }
 
 void CProgressDlg::slotSetFindRemaining( int remaining )
@@ -143,7 +165,6 @@ void CProgressDlg::slotSetFindRemaining( int remaining )
 void CProgressDlg::setFindValue( int value )
 {
     fImpl->findProgress->setValue( value );
-    slotUpdateStatusInfo();
 }
 
 int CProgressDlg::findValue() const
@@ -181,15 +202,18 @@ QString CProgressDlg::findFormat() const
     return fImpl->findProgress->format();
 }
 
-void CProgressDlg::setCurrentFindInfo( const QFileInfo &fileInfo )
+void CProgressDlg::setCurrentFindInfo( const QString &fileName, qint64 size )
 {
-    setCurrentInfo( fileInfo, fImpl->findText );
+    setCurrentInfo( fileName, size, fImpl->findText );
 }
 
-void CProgressDlg::setCurrentInfo( const QFileInfo &fileInfo, QLabel *label )
+void CProgressDlg::setCurrentInfo( const QString &fileName, qint64 size, QLabel *label )
 {
-    auto fileDirStr = fRelToDir.relativeFilePath( fileInfo.absoluteFilePath() );
-    auto fileSizeStr = NSABUtils::NFileUtils::byteSizeString( fileInfo );
+    if ( fileName.isEmpty() )
+        return;
+
+    auto fileDirStr = fRelToDir.relativeFilePath( fileName );
+    auto fileSizeStr = NSABUtils::NFileUtils::byteSizeString( size );
 
     label->setText( tr( "Current File '%2' (%3)" ).arg( fileDirStr ).arg( fileSizeStr ) );
 }
@@ -197,7 +221,6 @@ void CProgressDlg::setCurrentInfo( const QFileInfo &fileInfo, QLabel *label )
 void CProgressDlg::setMD5Value( int value )
 {
     fImpl->md5Progress->setValue( value );
-    slotUpdateStatusInfo();
 }
 
 int CProgressDlg::md5Value() const
@@ -230,64 +253,11 @@ QString CProgressDlg::md5Format() const
     return fImpl->md5Progress->format();
 }
 
-void CProgressDlg::setCurrentMD5Info( const QFileInfo &fileInfo )
-{
-    QString fileDirStr = fRelToDir.relativeFilePath( fileInfo.absoluteFilePath() );
-
-    fImpl->md5Text->setText( tr( "Current File '%2' (%3)" ).arg( fileDirStr ).arg( NSABUtils::NFileUtils::byteSizeString( fileInfo ) ) );
-}
-
 void CProgressDlg::setNumDuplicates( const std::pair< int, size_t > &numDuplicates )
 {
     fNumDuplicates = numDuplicates;
 }
 
-void CProgressDlg::slotMD5FileStarted( unsigned long long threadID, const QDateTime &startTime, const QString &fileName )
-{
-    fMap[ threadID ] = std::make_shared< SThreadInfo >( threadID, startTime, fileName );
-}
-
-void CProgressDlg::slotMD5ReadPositionStatus( unsigned long long threadID, const QDateTime & /*startTime*/, const QString &fileName, qint64 filePos )
-{
-    auto threadInfo = getThreadInfo( threadID, fileName );
-    if ( !threadInfo )
-        return;
-
-    threadInfo->fPos = filePos;
-    slotUpdateStatusInfo();
-}
-
-void CProgressDlg::slotMD5FileFinishedReading( unsigned long long threadID, const QDateTime &dt, const QString &fileName )
-{
-    auto threadInfo = getThreadInfo( threadID, fileName );
-    if ( !threadInfo )
-        return;
-
-    threadInfo->fState = SThreadInfo::EState::eComputing;
-    threadInfo->fReadingEndTime = dt;
-}
-
-void CProgressDlg::slotMD5FileFinishedComputing( unsigned long long threadID, const QDateTime &dt, const QString &fileName )
-{
-    auto threadInfo = getThreadInfo( threadID, fileName );
-    if ( !threadInfo )
-        return;
-
-    threadInfo->fState = SThreadInfo::EState::eFormating;
-    threadInfo->fComputingEndTime = dt;
-}
-
-void CProgressDlg::slotMD5FileFinished( unsigned long long threadID, const QDateTime &endTime, const QString &fileName, const QString &md5 )
-{
-    auto threadInfo = getThreadInfo( threadID, fileName );
-    if ( !threadInfo )
-        return;
-
-    threadInfo->fEndTime = endTime;
-    threadInfo->fMD5 = md5;
-    threadInfo->fState = SThreadInfo::EState::eFinished;
-}
-
 void CProgressDlg::setCancelText( const QString &label )
 {
     fImpl->buttonBox->button( QDialogButtonBox::StandardButton::Cancel )->setText( label );
@@ -306,16 +276,6 @@ void CProgressDlg::slotFindFinished()
     setStatusLabel();
 }
 
-void CProgressDlg::slotCurrentFindInfo( const QString &fileName )
-{
-    setCurrentFindInfo( QFileInfo( fileName ) );
-}
-
-void CProgressDlg::slotUpdateFilesFound( int numFilesFound )
-{
-    setFindValue( numFilesFound );
-}
-
 void CProgressDlg::setStatusLabel()
 {
     QStringList text;
@@ -346,143 +306,61 @@ void CProgressDlg::setStatusLabel()
 void CProgressDlg::setRelToDir( const QDir &relToDir )
 {
     fRelToDir = relToDir;
+    fJobModel->setRelToDir( relToDir );
 }
 
 void CProgressDlg::setMD5Finished()
 {
     fMD5Finished = true;
+    fUpdateTimer->stop();
     fImpl->md5Group->setVisible( false );
 
     setStatusLabel();
 }
 
-CProgressDlg::SThreadInfo::SThreadInfo( unsigned long long threadID, const QDateTime &start, const QString &fileName ) :
-    fStartTime( start ),
-    fFileInfo( fileName ),
-    fFileName( fileName ),
-    fThreadID( threadID )
-{
-    fSize = QFileInfo( fileName ).size();
-}
-
-QString CProgressDlg::SThreadInfo::msg() const
-{
-    auto retVal = QString( "%1: Filename: %2 (%3) (%4) - Current Runtime: %5 - Overall Runtime: %6" ).arg( fThreadID, 5, 10, QChar( '0' ) ).arg( fFileInfo.fileName() ).arg( getState() ).arg( NSABUtils::NFileUtils::byteSizeString( fFileInfo ) ).arg( getCurrentRuntimeString() ).arg( getRuntimeString() );
-    if ( fState == EState::eReading )
-        retVal += QString( " - File Position: %1 of %2 (%3%)" ).arg( NSABUtils::NFileUtils::byteSizeString( fPos ) ).arg( NSABUtils::NFileUtils::byteSizeString( fSize ) ).arg( getPercentage(), 2 );
-    if ( fState == EState::eFinished )
-        retVal += QString( " - MD5: %1" ).arg( fMD5 );
-    return retVal;
-}
-
-qint64 CProgressDlg::SThreadInfo::getCurrentRuntime() const
-{
-    QDateTime startTime;
-    QDateTime endTime = QDateTime::currentDateTime();
-    switch ( fState )
-    {
-        case EState::eReading:
-            startTime = fStartTime;
-            break;
-        case EState::eComputing:
-            startTime = fReadingEndTime;
-            break;
-        case EState::eFormating:
-            startTime = fComputingEndTime;
-            break;
-        case EState::eFinished:
-            endTime = startTime = fEndTime;
-            break;
-    }
-    return startTime.msecsTo( endTime );
-}
-
-QString CProgressDlg::SThreadInfo::getCurrentRuntimeString() const
-{
-    NSABUtils::CTimeString ts( getCurrentRuntime() );
-    return ts.toString();
-}
-
-qint64 CProgressDlg::SThreadInfo::getRuntime() const
-{
-    if ( fState == EState::eFinished )
-        return fStartTime.msecsTo( fEndTime );
-    else
-        return fStartTime.msecsTo( QDateTime::currentDateTime() );
-}
-
-QString CProgressDlg::SThreadInfo::getRuntimeString() const
-{
-    NSABUtils::CTimeString ts( getRuntime() );
-    return ts.toString();
-}
-
-std::shared_ptr< CProgressDlg::CProgressDlg::SThreadInfo > CProgressDlg::getThreadInfo( unsigned long long threadID, const QString &fileName ) const
-{
-    auto pos = fMap.find( threadID );
-    if ( pos == fMap.end() )
-        return {};
-
-    if ( ( *pos ).second->fFileInfo != QFileInfo( fileName ) )
-        return {};
-    return ( *pos ).second;
-}
-
-constexpr double sMaxPercentage = 25.0;
-
 void CProgressDlg::slotUpdateStatusInfo()
 {
-    auto currentTime = QDateTime::currentDateTime();
-    if ( ( ( fImpl->findProgress->value() + fImpl->md5Progress->value() + fImpl->computeProgress->value() ) % 500 ) == 0 )
-        fAdjustDelayed = true;
-
-    if ( fLastUpdate.isValid() && ( fLastUpdate.msecsTo( currentTime ) < 500 ) )
+    if ( !fScanProgress )
         return;
 
-    fLastUpdate = currentTime;
+    // sampled on a timer, the workers only update counters
+    if ( !fComputeNumFilesFinished )
+    {
+        auto counted = fScanProgress->numFiles( CScanProgress::EStage::eCounting );
+        auto current = fScanProgress->currentFile( CScanProgress::EStage::eCounting );
+        setComputeRange( 0, counted );
+        setFindRange( 0, counted );
+        setMD5Range( 0, counted );
+        setCurrentComputeInfo( current.first, current.second );
+    }
+    if ( !fFindFinished )
+    {
+        auto current = fScanProgress->currentFile( CScanProgress::EStage::eFinding );
+        setFindValue( fScanProgress->numFiles( CScanProgress::EStage::eFinding ) );
+        setCurrentFindInfo( current.first, current.second );
+    }
+    setMD5Value( fScanProgress->numFilesHashed() );
 
     auto threadPool = CMainWindow::threadPool();
     auto numActive = threadPool->activeThreadCount();
 
     auto cpuUtilization = getCPUUtilization();
 
-    //if ( !fHitMaxPercentage && ( cpuUtilization.second < sMaxPercentage ) ) //&& ( threadPool->maxThreadCount() < 3 * QThread::idealThreadCount() ) )
-    //    threadPool->setMaxThreadCount( threadPool->maxThreadCount() + 1 );
-    //else
-    //    fHitMaxPercentage = true;
-
     auto diskUtilization = getDiskUtilization();
 
-    QString txt = tr( "<dl>" ) + tr( "<dt>Number of Active Threads: %1 (MD5 Processing is behind by: %2) CPU Utilization: %3 Disk Read %4 Disk Write %5</dt></dl" ).arg( numActive ).arg( fImpl->findProgress->value() - fImpl->md5Progress->value() ).arg( cpuUtilization.first ).arg( diskUtilization.first ).arg( diskUtilization.second );
-    fImpl->statusHeader->setText( txt );
+    auto now = QDateTime::currentMSecsSinceEpoch();
+    auto jobs = fScanProgress->jobs();
+    auto eta = estimatedTimeRemaining( jobs, now );
 
-    std::map< qint64, std::shared_ptr< SThreadInfo > > runtimeMap;
-
-    for ( auto &&ii = fMap.begin(); ii != fMap.end(); )
-    {
-        if ( ( *ii ).second->expired() )
-            ii = fMap.erase( ii );
-        else
-        {
-            auto key = ( *ii ).second->fSize;
-
-            if ( fImpl->sortByThreadID->isChecked() )
-                key = ( *ii ).first;
-            else if ( fImpl->sortByPercentComplete->isChecked() )
-                key = static_cast< quint64 >( ( *ii ).second->getPercentageD() * 1000 );
-
-            runtimeMap[ key ] = ( *ii ).second;
-            ++ii;
-        }
-    }
+    QString txt = tr( "<dl>" ) + tr( "<dt>Number of Active Threads: %1 of %6 (MD5 Processing is behind by: %2) CPU Utilization: %3 Disk Read %4 Disk Write %5</dt><dt>Estimated Time Remaining: %7</dt></dl" ).arg( numActive ).arg( fScanProgress->numFiles( CScanProgress::EStage::eFinding ) - fScanProgress->numFilesHashed() ).arg( cpuUtilization.first ).arg( diskUtilization.first ).arg( diskUtilization.second ).arg( threadPool->maxThreadCount() ).arg( eta );
+    fImpl->statusHeader->setText( txt );
 
-    txt = "<dl>";
-    for ( auto &&ii = runtimeMap.rbegin(); ii != runtimeMap.rend(); ++ii )
-    {
-        txt += "<dd>" + ( *ii ).second->msg() + "</dd>";
-    }
-    txt += "<dl>";
-    fImpl->status->setHtml( txt );
+    auto sortBy = CJobStatusModel::ESortBy::eFileSize;
+    if ( fImpl->sortByThreadID->isChecked() )
+        sortBy = CJobStatusModel::ESortBy::eThreadID;
+    else if ( fImpl->sortByPercentComplete->isChecked() )
+        sortBy = CJobStatusModel::ESortBy::ePercentComplete;
+    fJobModel->update( jobs, sortBy );
 
     txt = "<dl>";
     txt += "<dt>" + tr( "Number of Duplicates Found: %1" ).arg( fNumDuplicates.first ) + "</dt>";
@@ -490,10 +368,35 @@ void CProgressDlg::slotUpdateStatusInfo()
     txt += "</dl>";
 
     fImpl->statusFooter->setText( txt );
+}
 
-    //if ( fAdjustDelayed )
-    //    adjustSize();
-    fAdjustDelayed = false;
+QString CProgressDlg::estimatedTimeRemaining( const std::vector< std::shared_ptr< const CScanProgress::SJob > > &jobs, qint64 now )
+{
+    auto bytesHashed = fScanProgress->bytesHashed();
+    auto elapsed = now - fLastRateSample;
+    if ( elapsed > 0 )
+    {
+        auto rate = ( bytesHashed - fLastBytesHashed ) * 1000.0 / elapsed;
+        fBytesPerSec = ( fBytesPerSec <= 0.0 ) ? rate : ( sRateSmoothing * rate + ( 1.0 - sRateSmoothing ) * fBytesPerSec );
+        fLastBytesHashed = bytesHashed;
+        fLastRateSample = now;
+    }
+    if ( fBytesPerSec <= 0.0 )
+        return tr( "Unknown" );
+
+    // largest files are hashed first, so the scan ends close to total bytes / bandwidth unless a running file takes longer on its own
+    auto retVal = static_cast< qint64 >( fScanProgress->bytesRemaining() * 1000.0 / fBytesPerSec );
+    for ( auto &&ii : jobs )
+    {
+        if ( ii->state() != CScanProgress::EJobState::eReading )
+            continue;
+        auto runtime = ii->runtime( now );
+        auto pos = ii->fPos.load( std::memory_order_relaxed );
+        if ( ( runtime <= 0 ) || ( pos <= 0 ) )
+            continue;
+        retVal = std::max( retVal, static_cast< qint64 >( ( ii->fSize - pos ) * static_cast< double >( runtime ) / pos ) );
+    }
+    return NSABUtils::CTimeString( retVal ).toString();
 }
 
 std::pair< QString, double > CProgressDlg::getCPUUtilization()
@@ -5,11 +5,14 @@
 #include <memory>
 #include <QDir>
 #include <QDateTime>
-#include <map>
+#include <vector>
+#include "ScanProgress.h"
 class QTreeWidgetItem;
 class QDir;
 class QLabel;
 class QFileInfo;
+class QTimer;
+class CJobStatusModel;
 namespace Ui { class CProgressDlg; };
 
 class CProgressDlg : public QWidget
@@ -30,11 +33,13 @@ public:
     void setFindFormat( const QString& format );
     QString findFormat() const;
 
-    void setCurrentFindInfo( const QFileInfo& fileInfo );
+    void setScanProgress( std::shared_ptr< CScanProgress > scanProgress );
+
+    void setCurrentFindInfo( const QString& fileName, qint64 size );
 
     void setComputeValue( int value );
     void setComputeRange( int min, int max );
-    void setCurrentComputeInfo( const QFileInfo & fileInfo );
+    void setCurrentComputeInfo( const QString& fileName, qint64 size );
     void setComputeFormat( const QString & format );
 
     void setStatusLabel();
@@ -48,7 +53,6 @@ public:
     int md5Max() const;
     void setMD5Format( const QString& format );
     QString md5Format() const;
-    void setCurrentMD5Info( const QFileInfo& fileInfo );
     void setMD5Finished();
 
     void setNumDuplicates( const std::pair< int, size_t > & numDuplicates );
@@ -59,22 +63,12 @@ public:
     bool wasCanceled() const { return fCanceled; }
 public Q_SLOTS:
     void slotFindFinished();
-    void slotCurrentFindInfo( const QString& fileName );
-    void slotCurrentComputeInfo( const QString & fileName );
-    void slotUpdateFilesFound( int numFilesFound );
 
     void slotCanceled();
     void slotSetFindRemaining( int remaining );
     void slotSetMD5Remaining( int remaining );
     void slotFinishedComputingFileCount();
 
-    void slotMD5FileStarted( unsigned long long threadID, const QDateTime& startTime, const QString& fileName );
-    void slotMD5ReadPositionStatus( unsigned long long threadID, const QDateTime &startTime, const QString &fileName, qint64 pos );
-
-    void slotMD5FileFinishedReading( unsigned long long threadID, const QDateTime &dt, const QString &filename );
-    void slotMD5FileFinishedComputing( unsigned long long threadID, const QDateTime& dt, const QString& filename );
-    void slotMD5FileFinished( unsigned long long threadID, const QDateTime& endTime, const QString& fileName, const QString& md5 );
-
     void slotUpdateStatusInfo();
 
 Q_SIGNALS:
@@ -83,8 +77,9 @@ private:
     std::pair< QString, double > getCPUUtilization();
     std::pair< QString, QString > getDiskUtilization();
 
-    void setCurrentInfo( const QFileInfo &fileInfo, QLabel *label );
+    void setCurrentInfo( const QString &fileName, qint64 size, QLabel *label );
     void setCountingFiles( bool counting );
+    QString estimatedTimeRemaining( const std::vector< std::shared_ptr< const CScanProgress::SJob > > &jobs, qint64 now );
 
     bool fCanceled{ false };
     bool fComputeNumFilesFinished{ false };
@@ -92,68 +87,15 @@ private:
     bool fMD5Finished{ false };
 
     QDir fRelToDir;
-    struct SThreadInfo
-    {
-        enum class EState
-        {
-            eReading,
-            eComputing,
-            eFormating,
-            eFinished
-        };
-        SThreadInfo() = delete;
-        SThreadInfo( unsigned long long threadID, const QDateTime& start, const QString& fileName );
-
-        QString msg() const;
-
-        int getPercentage() const { return static_cast< int >( getPercentageD() ); }
-        double getPercentageD() const { return fPos * 100.0 / fSize * 1.0; }
-
-        QString getState() const
-        {
-            if ( fState == EState::eReading )
-                return "Reading";
-            else if ( fState == EState::eComputing )
-                return "Computing";
-            else if ( fState == EState::eFormating )
-                return "Formating";
-            else
-                return "Finished";
-        }
-
-        bool expired() const // expires after 10 seconds
-        {
-            if ( fState != EState::eFinished )
-                return false;
-
-            return fEndTime.msecsTo( QDateTime::currentDateTime() ) > 10000;
-        }
-        qint64 getRuntime() const;
-        QString getRuntimeString() const;
-
-        qint64 getCurrentRuntime() const;
-        QString getCurrentRuntimeString() const;
-
-        EState fState{ EState::eReading };
-        QDateTime fStartTime;
-        QDateTime fReadingEndTime;
-        QDateTime fComputingEndTime;
-        QDateTime fEndTime;
-        QFileInfo fFileInfo;
-        QString fFileName;
-        QString fMD5;
-        quint64 fPos{ 0 };
-        quint64 fSize{ 0 };
-        unsigned long long fThreadID{ 0 };
-    };
-    std::shared_ptr< SThreadInfo > getThreadInfo( unsigned long long threadID, const QString &fileName ) const;
-    std::map< unsigned long long, std::shared_ptr< SThreadInfo > > fMap;
+    std::shared_ptr< CScanProgress > fScanProgress;
+    QTimer *fUpdateTimer{ nullptr };
+    qint64 fLastBytesHashed{ 0 };
+    qint64 fLastRateSample{ 0 };   // msecs since epoch
+    double fBytesPerSec{ 0.0 };   // smoothed over the updates
+    CJobStatusModel *fJobModel{ nullptr };
     std::unique_ptr< Ui::CProgressDlg > fImpl;
-    QDateTime fLastUpdate;
     std::pair< int, size_t > fNumDuplicates{ 0, 0 };
-    bool fAdjustDelayed{ false };
     std::pair< void *, std::tuple< void *, void *, void * > > fCPUUtilizationHandle{ nullptr, { nullptr, nullptr, nullptr } };
     std::pair< void *, std::pair< void *, void * > > fDiskIOUtilizationHandle{ nullptr, { nullptr, nullptr } };
-    bool fHitMaxPercentage{ false };
 };
 #endif 
\ No newline at end of file
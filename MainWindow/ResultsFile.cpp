@@ -0,0 +1,195 @@
+#include "ResultsFile.h"
+
+#include <QObject>
+#include <QSaveFile>
+#include <cstring>
+
+static const char sResultsMagic[ 8 ] = { 'F', 'D', 'R', 'E', 'S', 'U', 'L', 'T' };
+constexpr quint32 sResultsVersion = 1;
+constexpr quint32 sDeleteFlag = 0x1;
+
+static_assert( sizeof( CResultsFile::SHeader ) == 80, "Results header layout changed" );
+static_assert( sizeof( CResultsFile::SFileRecord ) == 40, "Results file record layout changed" );
+static_assert( sizeof( CResultsFile::SGroupRecord ) == 40, "Results group record layout changed" );
+
+bool CResultsFile::save( const QString &fileName, const QString &rootDir, const std::vector< SGroup > &groups, QString *errorMsg )
+{
+    QByteArray strings;
+    auto addString = [ &strings ]( const QString &str )
+    {
+        auto utf8 = str.toUtf8();
+        auto retVal = std::make_pair( static_cast< quint64 >( strings.size() ), static_cast< quint32 >( utf8.size() ) );
+        strings.append( utf8 );
+        return retVal;
+    };
+
+    SHeader header;
+    std::memset( &header, 0, sizeof( header ) );
+    std::memcpy( header.fMagic, sResultsMagic, sizeof( sResultsMagic ) );
+    header.fVersion = sResultsVersion;
+    std::tie( header.fRootDirOffset, header.fRootDirLength ) = addString( rootDir );
+
+    std::vector< SFileRecord > files;
+    std::vector< SGroupRecord > groupRecords;
+    groupRecords.reserve( groups.size() );
+    for ( auto &&group : groups )
+    {
+        SGroupRecord groupRecord;
+        std::memset( &groupRecord, 0, sizeof( groupRecord ) );
+        std::memcpy( groupRecord.fDigest, group.fDigest.fBytes.data(), sizeof( groupRecord.fDigest ) );
+        groupRecord.fFirstFile = files.size();
+        groupRecord.fNumFiles = static_cast< quint32 >( group.fFiles.size() );
+        groupRecord.fSize = group.fFiles.empty() ? 0 : group.fFiles.front().fMeta.fSize;
+        groupRecords.push_back( groupRecord );
+
+        for ( auto &&file : group.fFiles )
+        {
+            SFileRecord fileRecord;
+            std::memset( &fileRecord, 0, sizeof( fileRecord ) );
+            std::tie( fileRecord.fPathOffset, fileRecord.fPathLength ) = addString( file.fMeta.fPath );
+            fileRecord.fFlags = file.fDelete ? sDeleteFlag : 0;
+            fileRecord.fSize = file.fMeta.fSize;
+            fileRecord.fMTime = file.fMeta.fMTime;
+            fileRecord.fCTime = file.fMeta.fCTime;
+            files.push_back( fileRecord );
+        }
+    }
+
+    header.fNumFiles = files.size();
+    header.fNumGroups = groupRecords.size();
+    header.fFilesOffset = sizeof( SHeader );
+    header.fGroupsOffset = header.fFilesOffset + files.size() * sizeof( SFileRecord );
+    header.fStringsOffset = header.fGroupsOffset + groupRecords.size() * sizeof( SGroupRecord );
+    header.fStringsSize = strings.size();
+
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) )
+    {
+        if ( errorMsg )
+            *errorMsg = file.errorString();
+        return false;
+    }
+
+    file.write( reinterpret_cast< const char * >( &header ), sizeof( header ) );
+    file.write( reinterpret_cast< const char * >( files.data() ), files.size() * sizeof( SFileRecord ) );
+    file.write( reinterpret_cast< const char * >( groupRecords.data() ), groupRecords.size() * sizeof( SGroupRecord ) );
+    file.write( strings );
+    if ( !file.commit() )
+    {
+        if ( errorMsg )
+            *errorMsg = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+// true when count records of size bytes starting at offset end within total bytes, without overflowing
+static bool fits( quint64 offset, quint64 count, quint64 size, quint64 total )
+{
+    return ( offset <= total ) && ( count <= ( total - offset ) / size );
+}
+
+CResultsFile::CResultsFile( const QString &fileName ) :
+    fFile( std::make_unique< QFile >( fileName ) )
+{
+}
+
+CResultsFile::~CResultsFile()
+{
+    if ( fData )
+        fFile->unmap( const_cast< uchar * >( fData ) );
+}
+
+bool CResultsFile::open( QString *errorMsg )
+{
+    auto error = [ errorMsg ]( const QString &msg )
+    {
+        if ( errorMsg )
+            *errorMsg = msg;
+        return false;
+    };
+
+    if ( !fFile->open( QIODevice::ReadOnly ) )
+        return error( fFile->errorString() );
+
+    fDataSize = fFile->size();
+    if ( fDataSize < static_cast< qint64 >( sizeof( SHeader ) ) )
+        return error( QObject::tr( "'%1' is not a results file" ).arg( fFile->fileName() ) );
+
+    fData = fFile->map( 0, fDataSize );
+    if ( !fData )
+        return error( fFile->errorString() );
+
+    auto hdr = header();
+    bool aOK = ( std::memcmp( hdr->fMagic, sResultsMagic, sizeof( sResultsMagic ) ) == 0 ) && ( hdr->fVersion == sResultsVersion );
+    auto dataSize = static_cast< quint64 >( fDataSize );
+    aOK = aOK && fits( hdr->fFilesOffset, hdr->fNumFiles, sizeof( SFileRecord ), dataSize );
+    aOK = aOK && fits( hdr->fGroupsOffset, hdr->fNumGroups, sizeof( SGroupRecord ), dataSize );
+    aOK = aOK && fits( hdr->fStringsOffset, hdr->fStringsSize, 1, dataSize );
+
+    // every group's files must be within the file records, file() does not check them again
+    for ( quint64 ii = 0; aOK && ( ii < hdr->fNumGroups ); ++ii )
+    {
+        auto &&group = groupRecords()[ ii ];
+        aOK = fits( group.fFirstFile, group.fNumFiles, 1, hdr->fNumFiles );
+    }
+    if ( !aOK )
+    {
+        fFile->unmap( const_cast< uchar * >( fData ) );
+        fData = nullptr;
+        return error( QObject::tr( "'%1' is not a valid results file" ).arg( fFile->fileName() ) );
+    }
+    return true;
+}
+
+QString CResultsFile::string( quint64 offset, quint32 length ) const
+{
+    if ( !fits( offset, length, 1, header()->fStringsSize ) )
+        return {};
+    return QString::fromUtf8( reinterpret_cast< const char * >( fData + header()->fStringsOffset + offset ), length );
+}
+
+QString CResultsFile::rootDir() const
+{
+    return string( header()->fRootDirOffset, header()->fRootDirLength );
+}
+
+quint64 CResultsFile::numGroups() const
+{
+    return header()->fNumGroups;
+}
+
+quint64 CResultsFile::numFiles() const
+{
+    return header()->fNumFiles;
+}
+
+SDigest CResultsFile::groupDigest( quint64 group ) const
+{
+    SDigest retVal;
+    std::memcpy( retVal.fBytes.data(), groupRecords()[ group ].fDigest, SDigest::sSize );
+    return retVal;
+}
+
+qint64 CResultsFile::groupSize( quint64 group ) const
+{
+    return groupRecords()[ group ].fSize;
+}
+
+quint32 CResultsFile::groupFileCount( quint64 group ) const
+{
+    return groupRecords()[ group ].fNumFiles;
+}
+
+CResultsFile::SFile CResultsFile::file( quint64 group, quint32 fileInGroup ) const
+{
+    auto &&record = fileRecords()[ groupRecords()[ group ].fFirstFile + fileInGroup ];
+
+    SFile retVal;
+    retVal.fMeta.fPath = string( record.fPathOffset, record.fPathLength );
+    retVal.fMeta.fSize = record.fSize;
+    retVal.fMeta.fMTime = record.fMTime;
+    retVal.fMeta.fCTime = record.fCTime;
+    retVal.fDelete = ( record.fFlags & sDeleteFlag ) != 0;
+    return retVal;
+}
@@ -0,0 +1,96 @@
+#ifndef RESULTSFILE_H
+#define RESULTSFILE_H
+
+#include "KeepPolicy.h"
+#include "Digest.h"
+
+#include <QFile>
+#include <QString>
+#include <memory>
+#include <vector>
+
+// Saved scan results
+// The file is a fixed header, an array of fixed size file records (sorted by group), an array of fixed size group records
+// and a UTF-8 string pool.  It is memory mapped on open and the group records are validated there, file records are
+// decoded when asked for
+// Loading results is eager, CMainWindow::slotLoadResults decodes every file record up front
+// Values are stored in native byte order, the version check rejects files written on a machine of the other endianness
+class CResultsFile
+{
+public:
+    struct SFile
+    {
+        SFileMeta fMeta;   // fPath is relative to the root directory
+        bool fDelete{ false };
+    };
+
+    struct SGroup
+    {
+        SDigest fDigest;
+        std::vector< SFile > fFiles;
+    };
+
+    static bool save( const QString &fileName, const QString &rootDir, const std::vector< SGroup > &groups, QString *errorMsg = nullptr );
+
+    CResultsFile( const QString &fileName );
+    ~CResultsFile();
+
+    bool open( QString *errorMsg = nullptr );
+    bool isOpen() const { return fData != nullptr; }
+
+    QString rootDir() const;
+    quint64 numGroups() const;
+    quint64 numFiles() const;
+
+    SDigest groupDigest( quint64 group ) const;
+    qint64 groupSize( quint64 group ) const;
+    quint32 groupFileCount( quint64 group ) const;
+    SFile file( quint64 group, quint32 fileInGroup ) const;
+
+#pragma pack( push, 1 )
+    struct SHeader
+    {
+        char fMagic[ 8 ];
+        quint32 fVersion;
+        quint32 fReserved;
+        quint64 fNumFiles;
+        quint64 fNumGroups;
+        quint64 fFilesOffset;
+        quint64 fGroupsOffset;
+        quint64 fStringsOffset;
+        quint64 fStringsSize;
+        quint64 fRootDirOffset;   // in the string pool
+        quint32 fRootDirLength;
+        quint32 fReserved2;
+    };
+    struct SFileRecord
+    {
+        quint64 fPathOffset;   // in the string pool
+        quint32 fPathLength;
+        quint32 fFlags;
+        qint64 fSize;
+        qint64 fMTime;
+        qint64 fCTime;
+    };
+    struct SGroupRecord
+    {
+        quint8 fDigest[ 16 ];
+        quint64 fFirstFile;
+        quint32 fNumFiles;
+        quint32 fReserved;
+        qint64 fSize;
+    };
+#pragma pack( pop )
+
+private:
+    QString string( quint64 offset, quint32 length ) const;
+    const SHeader *header() const { return reinterpret_cast< const SHeader * >( fData ); }
+    const SFileRecord *fileRecords() const { return reinterpret_cast< const SFileRecord * >( fData + header()->fFilesOffset ); }
+    const SGroupRecord *groupRecords() const { return reinterpret_cast< const SGroupRecord * >( fData + header()->fGroupsOffset ); }
+
+    std::unique_ptr< QFile > fFile;
+    const uchar *fData{ nullptr };
+    qint64 fDataSize{ 0 };
+};
+
+#endif
@@ -0,0 +1,26 @@
+#include "ScanArena.h"
+
+constexpr size_t sBlockSize = 1024 * 1024;
+
+void *CScanArena::allocate( size_t size, size_t alignment )
+{
+    auto pos = reinterpret_cast< char * >( ( reinterpret_cast< quintptr >( fPos ) + alignment - 1 ) & ~quintptr( alignment - 1 ) );
+    if ( !fPos || ( pos + size > fEnd ) )
+    {
+        // a request larger than a block gets a block of its own
+        auto blockSize = std::max( sBlockSize, size + alignment );
+        fBlocks.emplace_back( new char[ blockSize ] );
+        fPos = fBlocks.back().get();
+        fEnd = fPos + blockSize;
+        pos = reinterpret_cast< char * >( ( reinterpret_cast< quintptr >( fPos ) + alignment - 1 ) & ~quintptr( alignment - 1 ) );
+    }
+    fPos = pos + size;
+    return pos;
+}
+
+void CScanArena::release()
+{
+    fBlocks.clear();
+    fPos = nullptr;
+    fEnd = nullptr;
+}
@@ -0,0 +1,83 @@
+#ifndef SCANARENA_H
+#define SCANARENA_H
+
+#include <QtGlobal>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Memory for the data of one scan, handed out from large blocks and only given back all at once by release
+// Nothing allocated from it is destroyed individually, so throwing away a scan costs one free per block
+// instead of one per file
+// Not thread safe
+class CScanArena
+{
+public:
+    CScanArena() = default;
+    CScanArena( const CScanArena & ) = delete;
+    CScanArena &operator=( const CScanArena & ) = delete;
+
+    void *allocate( size_t size, size_t alignment );
+    void release();
+
+private:
+    std::vector< std::unique_ptr< char[] > > fBlocks;
+    char *fPos{ nullptr };
+    char *fEnd{ nullptr };
+};
+
+// A growable array whose storage lives in a CScanArena
+// It has no destructor, the storage goes away with the arena, so it may only hold trivially copyable values
+template< typename T >
+class CArenaArray
+{
+    static_assert( std::is_trivially_copyable< T >::value, "arena arrays are copied with memcpy and never destroyed" );
+
+public:
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    void push_back( CScanArena &arena, const T &value )
+    {
+        if ( fSize == fCapacity )
+        {
+            // the old storage is left in the arena, a group that grows wastes at most as much as it uses
+            auto capacity = std::max< quint32 >( 1, fCapacity * 2 );
+            auto data = static_cast< T * >( arena.allocate( capacity * sizeof( T ), alignof( T ) ) );
+            if ( fSize )
+                std::memcpy( data, fData, fSize * sizeof( T ) );
+            fData = data;
+            fCapacity = capacity;
+        }
+        fData[ fSize++ ] = value;
+    }
+
+    iterator erase( iterator pos )
+    {
+        std::copy( pos + 1, end(), pos );
+        fSize--;
+        return pos;
+    }
+
+    size_t size() const { return fSize; }
+    bool empty() const { return fSize == 0; }
+
+    T &operator[]( size_t pos ) { return fData[ pos ]; }
+    const T &operator[]( size_t pos ) const { return fData[ pos ]; }
+    T &front() { return fData[ 0 ]; }
+    const T &front() const { return fData[ 0 ]; }
+
+    iterator begin() { return fData; }
+    iterator end() { return fData + fSize; }
+    const_iterator begin() const { return fData; }
+    const_iterator end() const { return fData + fSize; }
+
+private:
+    T *fData{ nullptr };
+    quint32 fSize{ 0 };
+    quint32 fCapacity{ 0 };
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include "ScanFilter.h"
+#include "DirEntry.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QObject>
+#include <QRegularExpression>
+
+// file names only fold case on the platforms whose file systems do by default
+#if defined( Q_OS_WIN ) || defined( Q_OS_MACOS )
+constexpr Qt::CaseSensitivity sPathCase = Qt::CaseInsensitive;
+#else
+constexpr Qt::CaseSensitivity sPathCase = Qt::CaseSensitive;
+#endif
+
+static std::optional< qint64 > parseSize( const QString &str, bool *aOK )
+{
+    *aOK = true;
+    if ( str.isEmpty() )
+        return {};
+
+    static QRegularExpression sRegExp( R"(^(?<num>\d+(\.\d+)?)\s*(?<unit>[kmgt]?)b?$)", QRegularExpression::CaseInsensitiveOption );
+    auto match = sRegExp.match( str.trimmed() );
+    if ( !match.hasMatch() )
+    {
+        *aOK = false;
+        return {};
+    }
+
+    auto value = match.captured( "num" ).toDouble();
+    auto unit = match.captured( "unit" ).toLower();
+    auto power = unit.isEmpty() ? 0 : ( QString( "kmgt" ).indexOf( unit ) + 1 );
+    for ( int ii = 0; ii < power; ++ii )
+        value *= 1024.0;
+    return static_cast< qint64 >( value );
+}
+
+static std::optional< qint64 > parseTime( const QString &str, bool *aOK )
+{
+    *aOK = true;
+    auto trimmed = str.trimmed();
+    if ( trimmed.isEmpty() )
+        return {};
+
+    if ( trimmed.endsWith( 'd', Qt::CaseInsensitive ) )
+    {
+        auto days = trimmed.left( trimmed.length() - 1 ).toInt( aOK );
+        if ( *aOK )
+            return QDateTime::currentDateTime().addDays( -days ).toMSecsSinceEpoch();
+        return {};
+    }
+
+    auto dt = QDateTime::fromString( trimmed, Qt::ISODate );
+    if ( !dt.isValid() )
+        dt = QDate::fromString( trimmed, Qt::ISODate ).startOfDay();
+    if ( !dt.isValid() )
+    {
+        *aOK = false;
+        return {};
+    }
+    return dt.toMSecsSinceEpoch();
+}
+
+void CScanFilter::clear()
+{
+    *this = CScanFilter();
+}
+
+bool CScanFilter::isEmpty() const
+{
+    return fIncludeExts.empty() && fExcludeExts.empty() && !fSize.first && !fSize.second && !fMTime.first && !fMTime.second && !fCTime.first && !fCTime.second && fIncludePaths.isEmpty() && fExcludePaths.isEmpty();
+}
+
+bool CScanFilter::setFilter( const QString &filter, const QString &rootDir, QString *errorMsg )
+{
+    CScanFilter retVal;
+    retVal.fFilter = filter;
+
+    auto rootPath = QDir( rootDir );
+    auto terms = filter.split( ';', Qt::SkipEmptyParts );
+    for ( auto &&term : terms )
+    {
+        auto name = term.section( ':', 0, 0 ).trimmed().toLower();
+        auto arg = term.section( ':', 1 ).trimmed();
+        bool aOK = !arg.isEmpty();
+
+        if ( ( name == "ext" ) || ( name == "!ext" ) )
+        {
+            auto &exts = ( name == "ext" ) ? retVal.fIncludeExts : retVal.fExcludeExts;
+            for ( auto &&ext : arg.split( ',', Qt::SkipEmptyParts ) )
+            {
+                auto curr = ext.trimmed().toLower();
+                if ( curr.startsWith( '.' ) )
+                    curr = curr.mid( 1 );
+                exts.insert( curr );
+            }
+        }
+        else if ( name == "size" )
+        {
+            auto range = arg.split( '-' );
+            aOK = aOK && ( range.count() == 2 );
+            if ( aOK )
+                retVal.fSize.first = parseSize( range[ 0 ], &aOK );
+            if ( aOK )
+                retVal.fSize.second = parseSize( range[ 1 ], &aOK );
+        }
+        else if ( ( name == "mtime" ) || ( name == "ctime" ) )
+        {
+            auto &timeRange = ( name == "mtime" ) ? retVal.fMTime : retVal.fCTime;
+            auto range = arg.split( ".." );
+            aOK = aOK && ( range.count() == 2 );
+            if ( aOK )
+                timeRange.first = parseTime( range[ 0 ], &aOK );
+            if ( aOK )
+                timeRange.second = parseTime( range[ 1 ], &aOK );
+        }
+        else if ( ( name == "path" ) || ( name == "!path" ) )
+        {
+            auto &paths = ( name == "path" ) ? retVal.fIncludePaths : retVal.fExcludePaths;
+            paths << QDir::cleanPath( rootPath.absoluteFilePath( QDir::fromNativeSeparators( arg ) ) );
+        }
+        else
+        {
+            if ( errorMsg )
+                *errorMsg = QObject::tr( "Unknown filter term '%1'" ).arg( term );
+            return false;
+        }
+
+        if ( !aOK )
+        {
+            if ( errorMsg )
+                *errorMsg = QObject::tr( "Invalid value in filter term '%1'" ).arg( term );
+            return false;
+        }
+    }
+
+    *this = retVal;
+    return true;
+}
+
+bool CScanFilter::inRange( qint64 value, const TRange &range )
+{
+    if ( range.first.has_value() && ( value < range.first.value() ) )
+        return false;
+    if ( range.second.has_value() && ( value > range.second.value() ) )
+        return false;
+    return true;
+}
+
+bool CScanFilter::isUnder( const QString &path, const QString &prefix )
+{
+    if ( !path.startsWith( prefix, sPathCase ) )
+        return false;
+    return ( path.length() == prefix.length() ) || ( path[ prefix.length() ] == '/' ) || prefix.endsWith( '/' );
+}
+
+bool CScanFilter::acceptsDir( const QString &absPath ) const
+{
+    for ( auto &&ii : fExcludePaths )
+    {
+        if ( isUnder( absPath, ii ) )
+            return false;
+    }
+
+    if ( fIncludePaths.isEmpty() )
+        return true;
+
+    // either inside an included path, or on the way down to one
+    for ( auto &&ii : fIncludePaths )
+    {
+        if ( isUnder( absPath, ii ) || isUnder( ii, absPath ) )
+            return true;
+    }
+    return false;
+}
+
+bool CScanFilter::acceptsFile( const QString &absPath, const SDirEntry &entry ) const
+{
+    if ( !inRange( entry.fSize, fSize ) )
+        return false;
+
+    if ( !fIncludeExts.empty() || !fExcludeExts.empty() )
+    {
+        auto suffix = entry.suffix().toLower();
+        if ( !fIncludeExts.empty() && ( fIncludeExts.find( suffix ) == fIncludeExts.end() ) )
+            return false;
+        if ( fExcludeExts.find( suffix ) != fExcludeExts.end() )
+            return false;
+    }
+
+    if ( ( fMTime.first || fMTime.second ) && !inRange( entry.fMTime, fMTime ) )
+        return false;
+    if ( ( fCTime.first || fCTime.second ) && !inRange( entry.fCTime, fCTime ) )
+        return false;
+
+    if ( !fIncludePaths.isEmpty() || !fExcludePaths.isEmpty() )
+    {
+        for ( auto &&ii : fExcludePaths )
+        {
+            if ( isUnder( absPath, ii ) )
+                return false;
+        }
+        if ( fIncludePaths.isEmpty() )
+            return true;
+        for ( auto &&ii : fIncludePaths )
+        {
+            if ( isUnder( absPath, ii ) )
+                return true;
+        }
+        return false;
+    }
+    return true;
+}
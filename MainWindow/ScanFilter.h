@@ -0,0 +1,50 @@
+#ifndef SCANFILTER_H
+#define SCANFILTER_H
+
+#include <QString>
+#include <QStringList>
+#include <optional>
+#include <unordered_set>
+#include <utility>
+
+struct SDirEntry;
+
+// Include/exclude filter applied while walking, before any work is scheduled for a file
+//
+// Terms are separated by ';'
+//    ext:<ext>,<ext>      - only files with one of the extensions
+//    !ext:<ext>,<ext>     - skip files with one of the extensions
+//    size:<min>-<max>     - size range, either end may be omitted, K/M/G/T suffixes are powers of 1024
+//    mtime:<from>..<to>   - modification time window, either end may be omitted
+//    ctime:<from>..<to>   - change/creation time window, either end may be omitted
+//    path:<prefix>        - only files under the prefix, relative prefixes are relative to the search directory
+//    !path:<prefix>       - skip everything under the prefix
+// Times are ISO dates (2024-12-31) or a number of days ago (365d)
+class CScanFilter
+{
+public:
+    bool setFilter( const QString &filter, const QString &rootDir, QString *errorMsg = nullptr );
+    QString filter() const { return fFilter; }
+    void clear();
+
+    bool isEmpty() const;
+
+    bool acceptsDir( const QString &absPath ) const;
+    bool acceptsFile( const QString &absPath, const SDirEntry &entry ) const;
+
+private:
+    using TRange = std::pair< std::optional< qint64 >, std::optional< qint64 > >;
+    static bool inRange( qint64 value, const TRange &range );
+    static bool isUnder( const QString &path, const QString &prefix );
+
+    QString fFilter;
+    std::unordered_set< QString > fIncludeExts;
+    std::unordered_set< QString > fExcludeExts;
+    TRange fSize;
+    TRange fMTime;   // msecs since epoch
+    TRange fCTime;   // msecs since epoch
+    QStringList fIncludePaths;
+    QStringList fExcludePaths;
+};
+
+#endif
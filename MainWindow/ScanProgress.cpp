@@ -0,0 +1,139 @@
+#include "ScanProgress.h"
+
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QObject>
+#include <algorithm>
+
+constexpr qint64 sFinishedJobExpiry = 10000;   // msecs
+constexpr int sCurrentFileInterval = 64;   // files found between updates of the current file, the dialog only samples it a few times a second
+
+CScanProgress::SJob::SJob( const QString &fileName, qint64 size ) :
+    fFileName( fileName ),
+    fSize( size )
+{
+}
+
+void CScanProgress::SJob::setState( EJobState state, qint64 now )
+{
+    fStateTime.store( now, std::memory_order_relaxed );
+    fState.store( static_cast< int >( state ), std::memory_order_release );
+}
+
+QString CScanProgress::SJob::stateName() const
+{
+    switch ( state() )
+    {
+        case EJobState::eQueued:
+            return QObject::tr( "Queued" );
+        case EJobState::eReading:
+            return QObject::tr( "Reading" );
+        case EJobState::eComputing:
+            return QObject::tr( "Computing" );
+        case EJobState::eFormating:
+            return QObject::tr( "Formating" );
+        default:
+            return QObject::tr( "Finished" );
+    }
+}
+
+double CScanProgress::SJob::percentage() const
+{
+    if ( fSize <= 0 )
+        return 100.0;
+    return fPos.load( std::memory_order_relaxed ) * 100.0 / fSize;
+}
+
+qint64 CScanProgress::SJob::currentRuntime( qint64 now ) const
+{
+    if ( state() == EJobState::eFinished )
+        return 0;
+    return now - fStateTime.load( std::memory_order_relaxed );
+}
+
+qint64 CScanProgress::SJob::runtime( qint64 now ) const
+{
+    auto end = ( state() == EJobState::eFinished ) ? fEndTime.load( std::memory_order_relaxed ) : now;
+    return end - fStartTime.load( std::memory_order_relaxed );
+}
+
+QString CScanProgress::SJob::md5() const
+{
+    if ( state() != EJobState::eFinished )
+        return {};
+    return fDigest.has_value() ? fDigest.value().toHex() : QString();
+}
+
+void CScanProgress::fileFound( EStage stage, const QString &fileName, qint64 size )
+{
+    auto &&curr = fStages[ static_cast< size_t >( stage ) ];
+    auto count = curr.fCount.fetch_add( 1, std::memory_order_relaxed );
+    curr.fBytes.fetch_add( size, std::memory_order_relaxed );
+
+    if ( ( count % sCurrentFileInterval ) != 0 )
+        return;
+    if ( !curr.fMutex.tryLock() )
+        return;   // the dialog is reading it, the next update will do
+    curr.fCurrentFile = fileName;
+    curr.fCurrentSize = size;
+    curr.fMutex.unlock();
+}
+
+std::pair< QString, qint64 > CScanProgress::currentFile( EStage stage ) const
+{
+    auto &&curr = fStages[ static_cast< size_t >( stage ) ];
+    QMutexLocker locker( &curr.fMutex );
+    return { curr.fCurrentFile, curr.fCurrentSize };
+}
+
+std::shared_ptr< CScanProgress::SJob > CScanProgress::createJob( const QString &fileName, qint64 size )
+{
+    fBytesQueued.fetch_add( size, std::memory_order_relaxed );
+    return std::make_shared< SJob >( fileName, size );
+}
+
+void CScanProgress::jobStarted( const std::shared_ptr< SJob > &job, unsigned long long threadID )
+{
+    auto now = QDateTime::currentMSecsSinceEpoch();
+    job->fThreadID.store( threadID, std::memory_order_relaxed );
+    job->fStartTime.store( now, std::memory_order_relaxed );
+    job->setState( EJobState::eReading, now );
+
+    QMutexLocker locker( &fJobsMutex );
+    fJobs.push_back( job );
+}
+
+void CScanProgress::jobRead( const std::shared_ptr< SJob > &job, qint64 pos )
+{
+    auto previous = job->fPos.exchange( pos, std::memory_order_relaxed );
+    fBytesHashed.fetch_add( pos - previous, std::memory_order_relaxed );
+}
+
+void CScanProgress::jobFinished( const std::shared_ptr< SJob > &job, const std::optional< SDigest > &digest )
+{
+    auto now = QDateTime::currentMSecsSinceEpoch();
+    job->fDigest = digest;
+    job->fEndTime.store( now, std::memory_order_relaxed );
+    job->setState( EJobState::eFinished, now );
+    fBytesHashed.fetch_add( job->fSize - job->fPos.load( std::memory_order_relaxed ), std::memory_order_relaxed );   // the rest of the job, the reader is done with it
+    fJobsRuntime.fetch_add( now - job->fStartTime.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+    fJobsFinished.fetch_add( 1, std::memory_order_relaxed );
+    fileHashed();
+}
+
+std::vector< std::shared_ptr< const CScanProgress::SJob > > CScanProgress::jobs()
+{
+    auto now = QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker locker( &fJobsMutex );
+    auto expired = [ now ]( const std::shared_ptr< SJob > &job ) { return ( job->state() == EJobState::eFinished ) && ( ( now - job->fEndTime.load( std::memory_order_relaxed ) ) > sFinishedJobExpiry ); };
+    fJobs.erase( std::remove_if( fJobs.begin(), fJobs.end(), expired ), fJobs.end() );
+    return { fJobs.begin(), fJobs.end() };
+}
+
+qint64 CScanProgress::bytesRemaining()
+{
+    auto toFind = std::max< qint64 >( 0, numBytes( EStage::eCounting ) - numBytes( EStage::eFinding ) );
+    auto toHash = std::max< qint64 >( 0, fBytesQueued.load( std::memory_order_relaxed ) - bytesHashed() );
+    return toFind + toHash;
+}
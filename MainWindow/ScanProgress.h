@@ -0,0 +1,103 @@
+#ifndef SCANPROGRESS_H
+#define SCANPROGRESS_H
+
+#include "Digest.h"
+
+#include <QMutex>
+#include <QString>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// Progress of a scan, written by the finder and hashing threads and sampled by the progress dialog on a timer
+// Counters are atomics and every running hash job has its own status slot, so reporting costs the same
+// no matter how many files are processed and nothing is queued across threads per file
+class CScanProgress
+{
+public:
+    enum class EStage
+    {
+        eCounting,
+        eFinding,
+        eNumStages
+    };
+
+    enum class EJobState
+    {
+        eQueued,
+        eReading,
+        eComputing,
+        eFormating,
+        eFinished
+    };
+
+    struct SJob
+    {
+        SJob( const QString &fileName, qint64 size );
+
+        EJobState state() const { return static_cast< EJobState >( fState.load( std::memory_order_acquire ) ); }
+        void setState( EJobState state, qint64 now );
+        QString stateName() const;
+        double percentage() const;
+        qint64 currentRuntime( qint64 now ) const;   // in the current state
+        qint64 runtime( qint64 now ) const;
+        QString md5() const;   // once finished
+
+        const QString fFileName;
+        const qint64 fSize;
+        std::atomic< qint64 > fPos{ 0 };
+        std::atomic< unsigned long long > fThreadID{ 0 };
+        std::atomic< qint64 > fStartTime{ 0 };   // msecs since epoch
+        std::atomic< qint64 > fStateTime{ 0 };
+        std::atomic< qint64 > fEndTime{ 0 };
+
+    private:
+        friend class CScanProgress;
+        std::atomic< int > fState{ static_cast< int >( EJobState::eQueued ) };
+        std::optional< SDigest > fDigest;   // written before the state becomes finished, no value when the file could not be read
+    };
+
+    CScanProgress() = default;
+
+    void fileFound( EStage stage, const QString &fileName, qint64 size );
+    int numFiles( EStage stage ) const { return fStages[ static_cast< size_t >( stage ) ].fCount.load( std::memory_order_relaxed ); }
+    std::pair< QString, qint64 > currentFile( EStage stage ) const;
+    qint64 numBytes( EStage stage ) const { return fStages[ static_cast< size_t >( stage ) ].fBytes.load( std::memory_order_relaxed ); }
+
+    void fileHashed() { fFilesHashed.fetch_add( 1, std::memory_order_relaxed ); }
+    int numFilesHashed() const { return fFilesHashed.load( std::memory_order_relaxed ); }
+
+    std::shared_ptr< SJob > createJob( const QString &fileName, qint64 size );
+    void jobStarted( const std::shared_ptr< SJob > &job, unsigned long long threadID );
+    void jobRead( const std::shared_ptr< SJob > &job, qint64 pos );   // called by the reader as it advances through the file
+    void jobFinished( const std::shared_ptr< SJob > &job, const std::optional< SDigest > &digest );
+    std::vector< std::shared_ptr< const SJob > > jobs();   // running and recently finished, finished jobs expire after 10 seconds
+
+    qint64 bytesHashed() const { return fBytesHashed.load( std::memory_order_relaxed ); }   // finished jobs plus the read position of the running ones
+    int numJobsFinished() const { return fJobsFinished.load( std::memory_order_relaxed ); }
+    qint64 bytesRemaining();   // still to be found plus queued and not yet hashed
+    qint64 jobsRuntime() const { return fJobsRuntime.load( std::memory_order_relaxed ); }   // msecs, summed over the finished jobs
+
+private:
+    struct SStage
+    {
+        std::atomic< int > fCount{ 0 };
+        std::atomic< qint64 > fBytes{ 0 };
+        mutable QMutex fMutex;   // only the finder writes, and only every few files, so it never waits on the dialog
+        QString fCurrentFile;
+        qint64 fCurrentSize{ 0 };
+    };
+    std::array< SStage, static_cast< size_t >( EStage::eNumStages ) > fStages;
+    std::atomic< int > fFilesHashed{ 0 };
+    std::atomic< qint64 > fBytesQueued{ 0 };
+    std::atomic< qint64 > fBytesHashed{ 0 };
+    std::atomic< int > fJobsFinished{ 0 };
+    std::atomic< qint64 > fJobsRuntime{ 0 };
+
+    QMutex fJobsMutex;
+    std::vector< std::shared_ptr< SJob > > fJobs;
+};
+
+#endif
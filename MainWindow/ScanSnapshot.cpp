@@ -0,0 +1,336 @@
+#include "ScanSnapshot.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <algorithm>
+#include <functional>
+
+constexpr quint32 sSnapshotMagic = 0x46445350;   // FDSP
+constexpr quint32 sSnapshotVersion = 5;
+
+// the smallest a record can be on disk, counts read from the file are checked against the bytes left before anything is allocated
+constexpr qint64 sMinDirSize = 4 + 8 + 8;   // empty name, mtime, number of entries
+constexpr qint64 sMinEntrySize = 4 + 1 + 1 + 8 + 8 + 8;   // empty name, flags, size and times
+constexpr qint64 sMinDigestSize = 4 + 8 + 8 + 4;   // empty name, size, mtime, the shortest digest
+
+static QDataStream &operator<<( QDataStream &stream, const SDirEntry &entry )
+{
+    return stream << entry.fName << entry.fIsDir << entry.fIsHidden << entry.fSize << entry.fMTime << entry.fCTime;
+}
+
+static QDataStream &operator>>( QDataStream &stream, SDirEntry &entry )
+{
+    return stream >> entry.fName >> entry.fIsDir >> entry.fIsHidden >> entry.fSize >> entry.fMTime >> entry.fCTime;
+}
+
+class CWriteSnapshot : public QRunnable
+{
+public:
+    CWriteSnapshot( std::function< void() > func ) :
+        fFunc( func )
+    {
+    }
+    void run() override { fFunc(); }
+
+private:
+    std::function< void() > fFunc;
+};
+
+CScanSnapshot::CScanSnapshot( const QString &rootDir ) :
+    fRootDir( rootDir )
+{
+    fSavePool.setMaxThreadCount( 1 );
+}
+
+CScanSnapshot::~CScanSnapshot()
+{
+    fSavePool.waitForDone();
+}
+
+QString CScanSnapshot::snapshotFileName( const QString &rootDir )
+{
+    auto dir = QDir( QStandardPaths::writableLocation( QStandardPaths::AppLocalDataLocation ) );
+    auto key = QCryptographicHash::hash( QDir::cleanPath( QDir( rootDir ).absolutePath() ).toUtf8(), QCryptographicHash::Md5 ).toHex();
+    return dir.absoluteFilePath( QString( "snapshots/%1.snapshot" ).arg( QString::fromLatin1( key ) ) );
+}
+
+bool CScanSnapshot::load()
+{
+    QFile file( snapshotFileName( fRootDir ) );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return false;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_12 );
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if ( ( magic != sSnapshotMagic ) || ( version < 1 ) || ( version > sSnapshotVersion ) )
+        return false;
+
+    QMutexLocker locker( &fMutex );
+    fDirs.clear();
+    fDigests.clear();
+
+    fComplete = true;   // version 1 was only written for finished scans
+    if ( version >= 2 )
+        stream >> fComplete;
+
+    auto fits = [ &file ]( quint64 count, qint64 minSize ) { return count <= static_cast< quint64 >( std::max< qint64 >( 0, file.size() - file.pos() ) / minSize ); };
+    auto corrupt = [ this ]()
+    {
+        fDirs.clear();
+        fDigests.clear();
+        return false;
+    };
+
+    quint64 numDirs = 0;
+    stream >> numDirs;
+    if ( ( stream.status() != QDataStream::Ok ) || !fits( numDirs, sMinDirSize ) )
+        return corrupt();
+    fDirs.reserve( numDirs );
+    for ( quint64 ii = 0; ii < numDirs; ++ii )
+    {
+        QString dirName;
+        SDir dir;
+        quint64 numEntries = 0;
+        stream >> dirName >> dir.fMTime >> numEntries;
+        if ( ( stream.status() != QDataStream::Ok ) || !fits( numEntries, sMinEntrySize ) )
+            return corrupt();
+        dir.fEntries.resize( numEntries );
+        for ( auto &&entry : dir.fEntries )
+        {
+            stream >> entry;
+            if ( stream.status() != QDataStream::Ok )
+                return corrupt();
+        }
+        fDirs[ dirName ] = std::move( dir );
+    }
+
+    quint64 numDigests = 0;
+    stream >> numDigests;
+    if ( ( stream.status() != QDataStream::Ok ) || !fits( numDigests, sMinDigestSize ) )
+        return corrupt();
+    fDigests.reserve( numDigests );
+    for ( quint64 ii = 0; ii < numDigests; ++ii )
+    {
+        QString fileName;
+        SFileDigest digest;
+        bool validDigest = true;   // a record with a bad digest is only dropped once all of its fields are read
+        stream >> fileName >> digest.fSize >> digest.fMTime;
+        if ( version >= 4 )
+            stream.readRawData( reinterpret_cast< char * >( digest.fDigest.fBytes.data() ), SDigest::sSize );
+        else
+        {
+            QString md5;   // earlier versions stored the hex string
+            stream >> md5;
+            auto fromHex = SDigest::fromHex( md5 );
+            validDigest = fromHex.has_value();
+            if ( validDigest )
+                digest.fDigest = fromHex.value();
+        }
+        if ( version >= 3 )
+            stream >> digest.fChunks;
+        if ( version >= 5 )
+        {
+            quint8 mode = 0;
+            stream >> mode;
+            digest.fMode = static_cast< EHashMode >( mode );
+        }
+        else
+            digest.fMode = digest.fChunks.isEmpty() ? EHashMode::eWholeFile : EHashMode::eTree;
+        if ( stream.status() != QDataStream::Ok )
+            return corrupt();
+        if ( validDigest )
+            fDigests[ fileName ] = digest;
+    }
+    return true;
+}
+
+bool CScanSnapshot::save( bool pruneUnvisited )
+{
+    auto state = copyState( pruneUnvisited );
+    fSavePool.waitForDone();
+    return write( snapshotFileName( fRootDir ), *state );
+}
+
+void CScanSnapshot::saveInBackground( bool pruneUnvisited )
+{
+    auto state = copyState( pruneUnvisited );
+    auto fileName = snapshotFileName( fRootDir );
+    fSavePool.start( new CWriteSnapshot( [ fileName, state ]() { write( fileName, *state ); } ) );
+}
+
+std::shared_ptr< CScanSnapshot::SState > CScanSnapshot::copyState( bool pruneUnvisited )
+{
+    QMutexLocker locker( &fMutex );
+
+    // directories that were not visited during a complete scan no longer exist (or are now ignored), drop them and their digests
+    if ( pruneUnvisited )
+    {
+        for ( auto ii = fDirs.begin(); ii != fDirs.end(); )
+        {
+            if ( fVisitedDirs.find( ( *ii ).first ) == fVisitedDirs.end() )
+                ii = fDirs.erase( ii );
+            else
+                ++ii;
+        }
+        for ( auto ii = fDigests.begin(); ii != fDigests.end(); )
+        {
+            auto dirName = QFileInfo( ( *ii ).first ).path();   // "/" for files directly under the root
+            if ( fDirs.find( dirName ) == fDirs.end() )
+                ii = fDigests.erase( ii );
+            else
+                ++ii;
+        }
+    }
+
+    // a flat copy, the strings are shared, so the finder and hasher threads are only held up for the copy and not the write
+    auto retVal = std::make_shared< SState >();
+    retVal->fComplete = fComplete;
+    retVal->fDirs.assign( fDirs.begin(), fDirs.end() );
+    retVal->fDigests.assign( fDigests.begin(), fDigests.end() );
+    return retVal;
+}
+
+bool CScanSnapshot::write( const QString &fileName, const SState &state )
+{
+    QDir().mkpath( QFileInfo( fileName ).absolutePath() );
+
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) )
+        return false;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_12 );
+    stream << sSnapshotMagic << sSnapshotVersion << state.fComplete;
+
+    stream << static_cast< quint64 >( state.fDirs.size() );
+    for ( auto &&ii : state.fDirs )
+    {
+        stream << ii.first << ii.second.fMTime << static_cast< quint64 >( ii.second.fEntries.size() );
+        for ( auto &&entry : ii.second.fEntries )
+            stream << entry;
+    }
+
+    stream << static_cast< quint64 >( state.fDigests.size() );
+    for ( auto &&ii : state.fDigests )
+    {
+        stream << ii.first << ii.second.fSize << ii.second.fMTime;
+        stream.writeRawData( reinterpret_cast< const char * >( ii.second.fDigest.fBytes.data() ), SDigest::sSize );
+        stream << ii.second.fChunks << static_cast< quint8 >( ii.second.fMode );
+    }
+
+    return file.commit();
+}
+
+bool CScanSnapshot::isComplete() const
+{
+    QMutexLocker locker( &fMutex );
+    return fComplete;
+}
+
+void CScanSnapshot::setComplete( bool complete )
+{
+    QMutexLocker locker( &fMutex );
+    fComplete = complete;
+}
+
+std::optional< std::vector< SDirEntry > > CScanSnapshot::entries( const QString &dirName, qint64 dirMTime )
+{
+    QMutexLocker locker( &fMutex );
+    auto pos = fDirs.find( dirName );
+    if ( ( pos == fDirs.end() ) || ( ( *pos ).second.fMTime != dirMTime ) )
+        return {};
+
+    fVisitedDirs.insert( dirName );
+    return ( *pos ).second.fEntries;
+}
+
+void CScanSnapshot::setEntries( const QString &dirName, qint64 dirMTime, const std::vector< SDirEntry > &entries )
+{
+    QMutexLocker locker( &fMutex );
+    fVisitedDirs.insert( dirName );
+    fDirs[ dirName ] = { dirMTime, entries };
+}
+
+std::optional< std::vector< SDirEntry > > CScanSnapshot::previousEntries( const QString &dirName ) const
+{
+    QMutexLocker locker( &fMutex );
+    auto pos = fDirs.find( dirName );
+    if ( pos == fDirs.end() )
+        return {};
+    return ( *pos ).second.fEntries;
+}
+
+bool CScanSnapshot::hasDir( const QString &dirName ) const
+{
+    QMutexLocker locker( &fMutex );
+    return fDirs.find( dirName ) != fDirs.end();
+}
+
+void CScanSnapshot::removeDir( const QString &dirName )
+{
+    QMutexLocker locker( &fMutex );
+    auto prefix = dirName + "/";
+    for ( auto ii = fDirs.begin(); ii != fDirs.end(); )
+    {
+        if ( ( ( *ii ).first == dirName ) || ( *ii ).first.startsWith( prefix ) )
+        {
+            fVisitedDirs.erase( ( *ii ).first );
+            ii = fDirs.erase( ii );
+        }
+        else
+            ++ii;
+    }
+}
+
+std::optional< SDigest > CScanSnapshot::digest( const QString &fileName, const SDirEntry &entry, EHashMode mode ) const
+{
+    QMutexLocker locker( &fMutex );
+    auto pos = fDigests.find( fileName );
+    if ( pos == fDigests.end() )
+        return {};
+    if ( ( ( *pos ).second.fSize != entry.fSize ) || ( ( *pos ).second.fMTime != entry.fMTime ) )
+        return {};
+    if ( ( *pos ).second.fMode != mode )
+        return {};
+    return ( *pos ).second.fDigest;
+}
+
+void CScanSnapshot::addPending( const QString &fileName, const SDirEntry &entry )
+{
+    QMutexLocker locker( &fMutex );
+    fPending[ fileName ] = { entry.fSize, entry.fMTime, SDigest(), EHashMode::eWholeFile, QByteArray() };
+}
+
+void CScanSnapshot::setDigest( const QString &fileName, const SDigest &digest, EHashMode mode, const QByteArray &chunks )
+{
+    QMutexLocker locker( &fMutex );
+    auto pos = fPending.find( fileName );
+    if ( pos == fPending.end() )
+        return;
+
+    auto fileDigest = ( *pos ).second;
+    fPending.erase( pos );
+    fileDigest.fDigest = digest;
+    fileDigest.fMode = mode;
+    fileDigest.fChunks = chunks;
+    fDigests[ fileName ] = fileDigest;
+}
+
+QByteArray CScanSnapshot::chunkDigests( const QString &fileName ) const
+{
+    QMutexLocker locker( &fMutex );
+    auto pos = fDigests.find( fileName );
+    if ( pos == fDigests.end() )
+        return {};
+    return ( *pos ).second.fChunks;
+}
@@ -0,0 +1,82 @@
+#ifndef SCANSNAPSHOT_H
+#define SCANSNAPSHOT_H
+
+#include "DirEntry.h"
+#include "Digest.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Persisted record of a previous scan of a root directory
+// Directories whose mtime has not changed reuse their recorded entries instead of being enumerated again (their files
+// are still stat'ed, a rewrite does not touch the directory), and files whose size and mtime have not changed reuse their recorded digest
+// A snapshot saved while a scan is still running is a checkpoint, loading it resumes the scan without rehashing finished files
+// Accessed from the finder threads and the GUI thread, all access is serialized, saves only hold the lock to copy the state
+class CScanSnapshot
+{
+public:
+    CScanSnapshot( const QString &rootDir );
+    ~CScanSnapshot();
+
+    static QString snapshotFileName( const QString &rootDir );
+
+    bool load();
+    bool save( bool pruneUnvisited );   // waits for the write
+    void saveInBackground( bool pruneUnvisited );   // the state is copied under the lock and written on the snapshot's own thread
+
+    bool isComplete() const;   // false when the last scan was interrupted before it finished
+    void setComplete( bool complete );
+
+    std::optional< std::vector< SDirEntry > > entries( const QString &dirName, qint64 dirMTime );
+    void setEntries( const QString &dirName, qint64 dirMTime, const std::vector< SDirEntry > &entries );
+    std::optional< std::vector< SDirEntry > > previousEntries( const QString &dirName ) const;   // regardless of the mtime
+    bool hasDir( const QString &dirName ) const;
+    void removeDir( const QString &dirName );   // and everything below it
+
+    std::optional< SDigest > digest( const QString &fileName, const SDirEntry &entry, EHashMode mode = EHashMode::eWholeFile ) const;   // only a digest computed the same way is reused
+    void addPending( const QString &fileName, const SDirEntry &entry );
+    void setDigest( const QString &fileName, const SDigest &digest, EHashMode mode = EHashMode::eWholeFile, const QByteArray &chunks = QByteArray() );
+    QByteArray chunkDigests( const QString &fileName ) const;   // of a tree or content defined hash, for partial matching
+
+private:
+    struct SDir
+    {
+        qint64 fMTime{ 0 };
+        std::vector< SDirEntry > fEntries;
+    };
+    struct SFileDigest
+    {
+        qint64 fSize{ 0 };
+        qint64 fMTime{ 0 };
+        SDigest fDigest;
+        EHashMode fMode{ EHashMode::eWholeFile };
+        QByteArray fChunks;   // the chunk digests or records unless the whole file was hashed
+    };
+
+    struct SState
+    {
+        bool fComplete{ false };
+        std::vector< std::pair< QString, SDir > > fDirs;
+        std::vector< std::pair< QString, SFileDigest > > fDigests;
+    };
+    std::shared_ptr< SState > copyState( bool pruneUnvisited );
+    static bool write( const QString &fileName, const SState &state );
+
+    QThreadPool fSavePool;   // one thread, background saves are written in order
+    mutable QMutex fMutex;
+    QString fRootDir;
+    std::unordered_map< QString, SDir > fDirs;
+    std::unordered_map< QString, SFileDigest > fDigests;
+    std::unordered_map< QString, SFileDigest > fPending;
+    std::unordered_set< QString > fVisitedDirs;
+    bool fComplete{ false };
+};
+
+#endif
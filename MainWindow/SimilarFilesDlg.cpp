@@ -0,0 +1,107 @@
+#include "SimilarFilesDlg.h"
+#include "ui_SimilarFilesDlg.h"
+
+#include "SABUtils/FileUtils.h"
+
+#include <QDir>
+#include <QHeaderView>
+#include <QLocale>
+#include <QTreeWidgetItem>
+
+CSimilarFilesDlg::CSimilarFilesDlg( const QString &relToDir, const std::vector< CChunkIndex::SSimilarFiles > &similarFiles, QWidget *parent ) :
+    QDialog( parent ),
+    fImpl( new Ui::CSimilarFilesDlg )
+{
+    fImpl->setupUi( this );
+    setWindowFlags( windowFlags() & ~Qt::WindowContextHelpButtonHint );
+
+    QLocale locale;
+    fImpl->summary->setText( tr( "%1 pairs of files share most of their content" ).arg( locale.toString( static_cast< qulonglong >( similarFiles.size() ) ) ) );
+
+    auto dir = QDir( relToDir );
+    QList< QTreeWidgetItem * > items;
+    for ( auto &&ii : similarFiles )
+    {
+        auto item = new QTreeWidgetItem( QStringList() << dir.relativeFilePath( ii.fFile1 ) << dir.relativeFilePath( ii.fFile2 ) << NSABUtils::NFileUtils::byteSizeString( ii.fSharedBytes ) << QString( "%1%" ).arg( ii.fRatio * 100.0, 0, 'f', 1 ) );
+        item->setTextAlignment( 2, Qt::AlignRight | Qt::AlignVCenter );
+        item->setTextAlignment( 3, Qt::AlignRight | Qt::AlignVCenter );
+        items << item;
+    }
+    fImpl->files->addTopLevelItems( items );
+    fImpl->files->header()->setSectionResizeMode( QHeaderView::ResizeToContents );
+}
+
+CSimilarFilesDlg::CSimilarFilesDlg( const QString &relToDir, const std::vector< CImageIndex::TGroup > &similarImages, QWidget *parent ) :
+    QDialog( parent ),
+    fImpl( new Ui::CSimilarFilesDlg )
+{
+    fImpl->setupUi( this );
+    setWindowFlags( windowFlags() & ~Qt::WindowContextHelpButtonHint );
+    setWindowTitle( tr( "Similar Images" ) );
+
+    QLocale locale;
+    fImpl->summary->setText( tr( "%1 groups of images look alike" ).arg( locale.toString( static_cast< qulonglong >( similarImages.size() ) ) ) );
+    fImpl->files->setColumnCount( 2 );
+    fImpl->files->setHeaderLabels( QStringList() << tr( "Image" ) << tr( "Distance" ) );
+    fImpl->files->setRootIsDecorated( true );
+
+    auto dir = QDir( relToDir );
+    QList< QTreeWidgetItem * > items;
+    for ( auto &&group : similarImages )
+    {
+        auto groupItem = new QTreeWidgetItem( QStringList() << dir.relativeFilePath( group.front().fFileName ) << tr( "%1 images" ).arg( group.size() ) );
+        for ( size_t ii = 1; ii < group.size(); ++ii )
+        {
+            auto item = new QTreeWidgetItem( groupItem, QStringList() << dir.relativeFilePath( group[ ii ].fFileName ) << QString::number( group[ ii ].fDistance ) );
+            item->setTextAlignment( 1, Qt::AlignRight | Qt::AlignVCenter );
+        }
+        groupItem->setTextAlignment( 1, Qt::AlignRight | Qt::AlignVCenter );
+        items << groupItem;
+    }
+    fImpl->files->addTopLevelItems( items );
+    fImpl->files->header()->setSectionResizeMode( QHeaderView::ResizeToContents );
+}
+
+CSimilarFilesDlg::CSimilarFilesDlg( const QString &relToDir, const CDuplicateDirs &duplicateDirs, QWidget *parent ) :
+    QDialog( parent ),
+    fImpl( new Ui::CSimilarFilesDlg )
+{
+    fImpl->setupUi( this );
+    setWindowFlags( windowFlags() & ~Qt::WindowContextHelpButtonHint );
+    setWindowTitle( tr( "Duplicate Directories" ) );
+
+    QLocale locale;
+    fImpl->summary->setText( tr( "%1 sets of identical directories, %2 directories contained in another" ).arg( locale.toString( static_cast< qulonglong >( duplicateDirs.groups().size() ) ) ).arg( locale.toString( static_cast< qulonglong >( duplicateDirs.subsets().size() ) ) ) );
+    fImpl->files->setColumnCount( 3 );
+    fImpl->files->setHeaderLabels( QStringList() << tr( "Directory" ) << tr( "Files" ) << tr( "Size" ) );
+    fImpl->files->setRootIsDecorated( true );
+
+    auto dir = QDir( relToDir );
+    auto addItem = []( QTreeWidgetItem *item )
+    {
+        item->setTextAlignment( 1, Qt::AlignRight | Qt::AlignVCenter );
+        item->setTextAlignment( 2, Qt::AlignRight | Qt::AlignVCenter );
+        return item;
+    };
+
+    QList< QTreeWidgetItem * > items;
+    for ( auto &&group : duplicateDirs.groups() )
+    {
+        auto groupItem = addItem( new QTreeWidgetItem( QStringList() << dir.relativeFilePath( group.fDirs.front() ) << locale.toString( group.fNumFiles ) << NSABUtils::NFileUtils::byteSizeString( group.fSize ) ) );
+        for ( size_t ii = 1; ii < group.fDirs.size(); ++ii )
+            new QTreeWidgetItem( groupItem, QStringList() << dir.relativeFilePath( group.fDirs[ ii ] ) );
+        items << groupItem;
+    }
+    for ( auto &&subset : duplicateDirs.subsets() )
+    {
+        auto subsetItem = addItem( new QTreeWidgetItem( QStringList() << dir.relativeFilePath( subset.fDir ) << locale.toString( subset.fNumFiles ) << NSABUtils::NFileUtils::byteSizeString( subset.fSize ) ) );
+        new QTreeWidgetItem( subsetItem, QStringList() << tr( "Contained in %1" ).arg( dir.relativeFilePath( subset.fContainedIn ) ) );
+        items << subsetItem;
+    }
+    fImpl->files->addTopLevelItems( items );
+    fImpl->files->header()->setSectionResizeMode( QHeaderView::ResizeToContents );
+}
+
+CSimilarFilesDlg::~CSimilarFilesDlg()
+{
+}
@@ -0,0 +1,29 @@
+#ifndef SIMILARFILESDLG_H
+#define SIMILARFILESDLG_H
+
+#include "ChunkIndex.h"
+#include "ImageIndex.h"
+#include "DuplicateDirs.h"
+
+#include <QDialog>
+#include <memory>
+#include <vector>
+
+namespace Ui { class CSimilarFilesDlg; };
+
+// The pairs of files that share most of their content defined chunks, most similar first
+// or the groups of images that look alike, largest first, or the duplicated directories
+class CSimilarFilesDlg : public QDialog
+{
+    Q_OBJECT
+public:
+    CSimilarFilesDlg( const QString &relToDir, const std::vector< CChunkIndex::SSimilarFiles > &similarFiles, QWidget *parent );
+    CSimilarFilesDlg( const QString &relToDir, const std::vector< CImageIndex::TGroup > &similarImages, QWidget *parent );
+    CSimilarFilesDlg( const QString &relToDir, const CDuplicateDirs &duplicateDirs, QWidget *parent );
+    virtual ~CSimilarFilesDlg() override;
+
+private:
+    std::unique_ptr< Ui::CSimilarFilesDlg > fImpl;
+};
+
+#endif
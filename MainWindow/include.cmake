@@ -21,23 +21,66 @@
 # SOFTWARE.
 
 set(qtproject_SRCS
+    ChunkIndex.cpp
+    ConcurrencyController.cpp
+    DigestIndex.cpp
+    DirWatcher.cpp
+    DupeModel.cpp
+    DuplicateDirs.cpp
     FileFinder.cpp
+    HashPipeline.cpp
+    IconLoader.cpp
+    IgnoreMatcher.cpp
+    ImageIndex.cpp
+    JobStatusModel.cpp
+    KeepPolicy.cpp
     MainWindow.cpp
+    NameMatcher.cpp
+    PathStore.cpp
     ProgressDlg.cpp
+    ResultsFile.cpp
+    ScanArena.cpp
+    ScanFilter.cpp
+    ScanProgress.cpp
+    ScanSnapshot.cpp
+    SimilarFilesDlg.cpp
 )
 
 set(qtproject_H
+    ConcurrencyController.h
+    DirWatcher.h
+    DupeModel.h
     FileFinder.h
+    IconLoader.h
+    JobStatusModel.h
     MainWindow.h
     ProgressDlg.h
+    SimilarFilesDlg.h
 )
 
 set(project_H
+    ChunkIndex.h
+    Digest.h
+    DigestIndex.h
+    DirEntry.h
+    DuplicateDirs.h
+    HashPipeline.h
+    IgnoreMatcher.h
+    ImageIndex.h
+    KeepPolicy.h
+    NameMatcher.h
+    PathStore.h
+    ResultsFile.h
+    ScanArena.h
+    ScanFilter.h
+    ScanProgress.h
+    ScanSnapshot.h
 )
 
 set(qtproject_UIS
     MainWindow.ui
     ProgressDlg.ui
+    SimilarFilesDlg.ui
 )
 
 set(qtproject_QRC